@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lib/bufferLexer.h"
+#include "lib/token.h"
+#include "lib/infixParser.h"
+#include "lib/arena.h"
+#include "lib/symbolTable.h"
+#include "lib/statement.h"
+
+// Benchmarks the front end and evaluator on generated workloads. Every workload is timed
+// phase by phase (lex, parse, print, evaluate) and through the whole calc loop, and each
+// result is printed as one JSON object per line.
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Parses the N of a --flag=N option; returns 0 when it is not a positive number
+size_t parseCount(const std::string& text) {
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') {
+        return 0;
+    }
+    return value;
+}
+
+// Workload generators. All randomness comes from the generator passed in, so a seed
+// always produces the same input.
+class Generator {
+public:
+    Generator(unsigned seed) : random(seed) {}
+
+    // Balanced binary trees `depth` levels deep
+    std::vector<std::string> deepNesting(size_t lines, int depth) {
+        std::vector<std::string> result;
+        result.push_back("x = 3");
+        for (size_t i = 1; i < lines; ++i) {
+            std::string line;
+            appendNested(line, depth);
+            result.push_back(line);
+        }
+        return result;
+    }
+
+    // Long flat sums without parentheses
+    std::vector<std::string> wideSums(size_t lines, int terms) {
+        std::vector<std::string> result;
+        for (size_t i = 0; i < lines; ++i) {
+            std::string line = number();
+            for (int t = 1; t < terms; ++t) {
+                line += pick({" + ", " - "});
+                line += number();
+            }
+            result.push_back(line);
+        }
+        return result;
+    }
+
+    // Statements over a large pool of variables, which are all defined first
+    std::vector<std::string> manyVariables(size_t lines, size_t variables) {
+        std::vector<std::string> result;
+        for (size_t v = 0; v < variables; ++v) {
+            result.push_back(variable(v) + " = " + number());
+        }
+        for (size_t i = result.size(); i < lines; ++i) {
+            std::string line = variable(below(variables)) + " = ";
+            for (int t = 0; t < 8; ++t) {
+                if (t > 0) {
+                    line += pick({" + ", " * ", " - "});
+                }
+                line += variable(below(variables));
+            }
+            result.push_back(line);
+        }
+        return result;
+    }
+
+    // Comparisons combined with logical operators
+    std::vector<std::string> booleanHeavy(size_t lines, int clauses) {
+        std::vector<std::string> result;
+        result.push_back("a = 4");
+        result.push_back("b = 7");
+        for (size_t i = 2; i < lines; ++i) {
+            std::string line;
+            for (int c = 0; c < clauses; ++c) {
+                if (c > 0) {
+                    line += pick({" & ", " | ", " ^ "});
+                }
+                std::string comparison = "(" + pick({"a", "b", number()}) + pick({" < ", " > ", " <= ", " >= "})
+                                       + pick({"a", "b", number()}) + ")";
+                line += below(4) == 0 ? pick({"true", "false"}) : comparison;
+            }
+            result.push_back(line);
+        }
+        return result;
+    }
+
+    // Mostly failing lines: lexer errors, parser errors and runtime errors
+    std::vector<std::string> errorHeavy(size_t lines) {
+        std::vector<std::string> result;
+        for (size_t i = 0; i < lines; ++i) {
+            switch (below(6)) {
+            case 0:
+                result.push_back("(" + number() + " + " + number() + " $ 2)");
+                break;
+            case 1:
+                result.push_back("(" + number() + " * (" + number() + " + 1)");
+                break;
+            case 2:
+                result.push_back(number() + " + * " + number());
+                break;
+            case 3:
+                result.push_back(number() + " / (" + number() + " - " + number() + " * 0 - " + number() + " + "
+                                 + number() + ") / 0");
+                break;
+            case 4:
+                result.push_back("undefined" + std::to_string(below(100)) + " + " + number());
+                break;
+            default:
+                result.push_back("(3 < 4) + " + number());
+                break;
+            }
+        }
+        return result;
+    }
+
+    // A long script that keeps updating a few variables from each other
+    std::vector<std::string> longScript(size_t lines) {
+        const std::vector<std::string> names = {"total", "count", "rate", "limit", "delta"};
+        std::vector<std::string> result;
+        for (const std::string& name : names) {
+            result.push_back(name + " = " + number());
+        }
+        for (size_t i = result.size(); i < lines; ++i) {
+            const std::string& target = names[below(names.size())];
+            std::string line = target + " = (" + names[below(names.size())] + pick({" + ", " - ", " * "})
+                             + number() + ")" + pick({" + ", " - "}) + names[below(names.size())];
+            if (below(10) == 0) {
+                line = "(" + target + " > " + number() + ") | (" + names[below(names.size())] + " == 0)";
+            }
+            result.push_back(line);
+        }
+        return result;
+    }
+
+private:
+    std::mt19937 random;
+
+    size_t below(size_t limit) {
+        return std::uniform_int_distribution<size_t>(0, limit - 1)(random);
+    }
+
+    std::string pick(std::initializer_list<std::string> choices) {
+        return *(choices.begin() + below(choices.size()));
+    }
+
+    std::string number() {
+        if (below(3) == 0) {
+            return std::to_string(below(1000)) + "." + std::to_string(below(100));
+        }
+        return std::to_string(1 + below(999));
+    }
+
+    std::string variable(size_t index) {
+        return "v" + std::to_string(index);
+    }
+
+    void appendNested(std::string& line, int depth) {
+        if (depth == 0) {
+            line += below(4) == 0 ? "x" : number();
+            return;
+        }
+        line += '(';
+        appendNested(line, depth - 1);
+        line += pick({" + ", " - ", " * "});
+        appendNested(line, depth - 1);
+        line += ')';
+    }
+};
+
+// Per-line latencies of one phase over one workload
+class PhaseTimer {
+public:
+    PhaseTimer(size_t lines) {
+        latencies.reserve(lines);
+    }
+
+    void start() {
+        begin = Clock::now();
+    }
+
+    // lineBytes is the size of the input line the phase worked on
+    void stop(size_t lineBytes) {
+        bytes += lineBytes;
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+    }
+
+    // Prints one JSON line with throughput and latency percentiles
+    void report(const std::string& workload, const std::string& phase) {
+        std::vector<long long> sorted = latencies;
+        std::sort(sorted.begin(), sorted.end());
+        long long total = 0;
+        for (long long latency : sorted) {
+            total += latency;
+        }
+        double seconds = total / 1e9;
+        double linesPerSecond = seconds > 0 ? sorted.size() / seconds : 0;
+        double megabytesPerSecond = seconds > 0 ? bytes / seconds / 1e6 : 0;
+        std::cout << "{\"workload\":\"" << workload << "\",\"phase\":\"" << phase << "\""
+                  << ",\"lines\":" << sorted.size() << ",\"bytes\":" << bytes
+                  << ",\"seconds\":" << seconds
+                  << ",\"lines_per_sec\":" << linesPerSecond << ",\"mb_per_sec\":" << megabytesPerSecond
+                  << ",\"p50_ns\":" << percentile(sorted, 50) << ",\"p90_ns\":" << percentile(sorted, 90)
+                  << ",\"p99_ns\":" << percentile(sorted, 99)
+                  << ",\"max_ns\":" << (sorted.empty() ? 0 : sorted.back()) << "}" << std::endl;
+    }
+
+private:
+    Clock::time_point begin;
+    std::vector<long long> latencies;
+    size_t bytes = 0;
+
+    static long long percentile(const std::vector<long long>& sorted, int percent) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        return sorted[(sorted.size() - 1) * percent / 100];
+    }
+};
+
+// Times the phases separately, each over every line, then the calc loop over every line
+void runWorkload(const std::string& name, const std::vector<std::string>& lines) {
+    // Lex: one BufferLexer per line, as calc does
+    std::vector<TokenBuffer> tokens(lines.size());
+    std::vector<bool> lexed(lines.size(), false);
+    PhaseTimer lexTimer(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        lexTimer.start();
+        try {
+            BufferLexer lexer(lines[i]);
+            tokens[i] = lexer.tokenize();
+            lexed[i] = true;
+        } catch (const SyntaxError&) {
+        }
+        lexTimer.stop(lines[i].size() + 1);
+    }
+    lexTimer.report(name, "lex");
+
+    // Parse: trees stay in one arena so the later phases can use them
+    SymbolTable symbolTable;
+    Arena arena;
+    std::vector<ASTNode*> roots(lines.size(), nullptr);
+    PhaseTimer parseTimer(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (!lexed[i]) {
+            continue;
+        }
+        parseTimer.start();
+        try {
+            infixParser parser(tokens[i], symbolTable, arena);
+            roots[i] = parser.infixparse();
+        } catch (const std::runtime_error&) {
+        }
+        parseTimer.stop(lines[i].size() + 1);
+    }
+    parseTimer.report(name, "parse");
+
+    // Print into one reused buffer, as parseStatement() does
+    std::string text;
+    PhaseTimer printTimer(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (!roots[i]) {
+            continue;
+        }
+        printTimer.start();
+        text.clear();
+        appendInfix(roots[i], text);
+        printTimer.stop(lines[i].size() + 1);
+    }
+    printTimer.report(name, "print");
+
+    // Evaluate with ASTNode::evaluate, in input order so assignments are seen by later lines
+    PhaseTimer evaluateTimer(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (!roots[i]) {
+            continue;
+        }
+        evaluateTimer.start();
+        try {
+            roots[i]->evaluate(symbolTable);
+        } catch (const std::runtime_error&) {
+        }
+        evaluateTimer.stop(lines[i].size() + 1);
+    }
+    evaluateTimer.report(name, "evaluate");
+
+    // The whole default calc loop, with its own symbol table
+    SymbolTable calcSymbols;
+    LiveDefinitions liveDefinitions(calcSymbols);
+    StatementExecutor executor(calcSymbols, Engine::TREE, &liveDefinitions);
+    Arena lineArena;
+    ParsedStatement statement;
+    std::ostringstream output;
+    PhaseTimer calcTimer(lines.size());
+    for (const std::string& line : lines) {
+        calcTimer.start();
+        parseStatement(line, calcSymbols, lineArena, statement);
+        executor.execute(statement, output);
+        lineArena.reset();
+        calcTimer.stop(line.size() + 1);
+        output.str(std::string());
+    }
+    calcTimer.report(name, "calc");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned seed = 1;
+    size_t lines = 20000;
+    std::string only;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--seed=", 0) == 0 && parseCount(arg.substr(7)) > 0) {
+            seed = parseCount(arg.substr(7));
+        } else if (arg.rfind("--lines=", 0) == 0 && parseCount(arg.substr(8)) > 0) {
+            lines = parseCount(arg.substr(8));
+        } else if (arg.rfind("--workload=", 0) == 0) {
+            only = arg.substr(11);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--seed=N] [--lines=N]"
+                      << " [--workload=deep|wide|variables|boolean|errors|script]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Each workload gets its own generator, so filtering does not change the others' input
+    struct Workload {
+        std::string name;
+        std::vector<std::string> (*generate)(Generator&, size_t);
+    };
+    const Workload workloads[] = {
+        {"deep", [](Generator& g, size_t n) { return g.deepNesting(n / 20, 10); }},
+        {"wide", [](Generator& g, size_t n) { return g.wideSums(n / 10, 200); }},
+        {"variables", [](Generator& g, size_t n) { return g.manyVariables(n, 1000); }},
+        {"boolean", [](Generator& g, size_t n) { return g.booleanHeavy(n, 12); }},
+        {"errors", [](Generator& g, size_t n) { return g.errorHeavy(n); }},
+        {"script", [](Generator& g, size_t n) { return g.longScript(n * 5); }},
+    };
+    bool found = false;
+    for (const Workload& workload : workloads) {
+        if (!only.empty() && workload.name != only) {
+            continue;
+        }
+        found = true;
+        Generator generator(seed);
+        runWorkload(workload.name, workload.generate(generator, lines));
+    }
+    if (!found) {
+        std::cerr << "Unknown workload: " << only << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3,98 +3,290 @@
 #include <iomanip>
 #include <stdexcept>
 #include <sstream>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <algorithm>
+#include <csignal>
 #include "lib/lexer.h"
+#include "lib/bufferLexer.h"
 #include "lib/token.h"
 #include "lib/infixParser.h"
+#include "lib/arena.h"
+#include "lib/statement.h"
+#include "lib/statementCache.h"
+#include "lib/interpreter.h"
+#include "lib/threadPool.h"
+#include "lib/parallelExecutor.h"
+#include "lib/stats.h"
+#include "lib/server.h"
 
 class TypeError : public std::runtime_error {
 public:
     TypeError(const std::string& message) : std::runtime_error(message) {}
 };
 
-int main() {
-    std::map<std::string, double> symbolTable; // Create the symbol table
+// Parses the N of a --flag=N option; returns 0 when it is not a positive number
+static size_t parseCount(const std::string& text) {
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') {
+        return 0;
+    }
+    return value;
+}
+
+// Set by SIGUSR1 when --stats is on; the input loops print the stats at the next line
+static volatile std::sig_atomic_t statsRequested = 0;
+
+static void requestStats(int /* signal */) {
+    statsRequested = 1;
+}
+
+// Prints the stats now if SIGUSR1 arrived since the last check
+static void printRequestedStats() {
+    if (statsRequested) {
+        statsRequested = 0;
+        Stats::print(std::cerr);
+    }
+}
+
+// Set by SIGINT or SIGTERM in --serve mode; the server stops after its current events
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void requestStop(int /* signal */) {
+    stopRequested = 1;
+}
 
+// Node allocation totals reported by --alloc-stats
+struct AllocationStats {
+    size_t nodes = 0;
+    size_t blocks = 0;
+
+    // source is an Arena or anything else that owns arenas, such as an Interpreter
+    template <typename Source>
+    void add(const Source& source) {
+        nodes += source.objectsAllocated();
+        blocks += source.blocksAllocated();
+    }
+};
+
+// Default mode: read, parse, evaluate and print one line at a time. Each line's tree
+// lives in one arena that is reset afterwards, so steady state needs no malloc. With a
+// cache, lines seen before are not parsed again.
+static void runLines(std::istream& input, Interpreter& interpreter, AllocationStats& allocationStats) {
     while (true) {
         // Reads input
         std::string inputLine;
-        if (!std::getline(std::cin, inputLine)) {
+        if (!std::getline(input, inputLine)) {
             break;
         }
         // Below line is debug helper that prints out the input
         // std::cout << "Debug Input: " << inputLine << std::endl;
-        std::istringstream inputStream(inputLine);
-        Lexer lexer(inputStream);
+        interpreter.execute(inputLine, std::cout);
+        std::cout.flush();
+        Stats::addLines(1);
+        printRequestedStats();
+    }
+    allocationStats.add(interpreter);
+}
 
-        try {
-            // Tokenize and parse the current line
-            std::vector<Token> tokens = lexer.tokenize();
-
-            int openParenthesesCount = 0;  // Track open parentheses
-            for (const Token& token : tokens) {
-                if (token.type == TokenType::LEFT_PAREN) {
-                    openParenthesesCount++;
-                } else if (token.type == TokenType::RIGHT_PAREN) {
-                    openParenthesesCount--;
-                    if (openParenthesesCount < 0) {
-                        throw UnexpectedTokenException(")", lexer.line, lexer.column);
-                    }
-                }
-            }
+// Whole-program mode: read the input into one buffer and lex it in a single pass, then
+// parse and evaluate its lines one after another from that token buffer. Output matches
+// the line-by-line loop, except that errors report the line they are on.
+static void runProgram(std::istream& input, SymbolTable& symbolTable, StatementExecutor& executor,
+                       AllocationStats& allocationStats) {
+    std::string source;
+    char chunk[1 << 16];
+    while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+        source.append(chunk, input.gcount());
+    }
+
+    BufferLexer lexer(source);
+    const TokenBuffer* tokens;
+    {
+        ScopedPhaseTimer timer(Phase::LEX);
+        tokens = &lexer.tokenizeLines();
+    }
+    Stats::addTokens(tokens->tokens.size());
+
+    Arena arena;
+    ParsedStatement statement;
+    size_t first = 0;
+    for (size_t i = 0; i < tokens->tokens.size(); ++i) {
+        TokenKind kind = tokens->tokens[i].kind;
+        if (kind != TokenKind::NEWLINE && kind != TokenKind::END) {
+            continue;
+        }
+        // After a final newline there is no further line, as with std::getline
+        if (kind == TokenKind::END && first == i && (source.empty() || source.back() == '\n')) {
+            break;
+        }
+        parseStatement(*tokens, first, i, symbolTable, arena, statement);
+        executor.execute(statement, std::cout);
+        arena.reset();
+        first = i + 1;
+        Stats::addLines(1);
+        printRequestedStats();
+    }
+    std::cout.flush();
+    allocationStats.add(arena);
+}
+
+// Statements kept parsed by default in line-by-line mode
+static const size_t DEFAULT_CACHE_SIZE = 256;
+
+// Lines lexed and parsed together in batch mode before they are evaluated
+static const size_t BATCH_LINES = 16384;
+
+// Batch mode: lex and parse a block of lines on the thread pool, then evaluate and
+// print them in order, so the output matches the line-by-line loop. With parallelEval,
+// statements that do not depend on each other are also evaluated in parallel.
+static void runBatch(std::istream& input, SymbolTable& symbolTable, StatementExecutor& executor, Engine engine,
+                     LiveDefinitions& liveDefinitions, size_t threadCount, bool parallelEval,
+                     AllocationStats& allocationStats) {
+    ThreadPool pool(threadCount);
+    ParallelExecutor parallelExecutor(symbolTable, engine, pool, &liveDefinitions);
+    // One arena per thread holds the trees of the current block
+    std::vector<std::unique_ptr<Arena>> arenas;
+    for (size_t i = 0; i < pool.size(); ++i) {
+        arenas.push_back(std::make_unique<Arena>());
+    }
+    std::vector<std::string> lines;
+    std::vector<ParsedStatement> statements;
 
-            if (openParenthesesCount > 0) {
-                throw UnexpectedTokenException("END", lexer.line, lexer.column+1);
+    while (true) {
+        lines.clear();
+        std::string inputLine;
+        while (lines.size() < BATCH_LINES && std::getline(input, inputLine)) {
+            lines.push_back(std::move(inputLine));
+        }
+        if (lines.empty()) {
+            break;
+        }
+
+        // Statements left from the previous block are overwritten by parseStatement()
+        statements.resize(lines.size());
+        pool.parallelFor(lines.size(), [&](size_t i, size_t thread) {
+            try {
+                parseStatement(lines[i], symbolTable, *arenas[thread], statements[i]);
+            } catch (...) {
+                statements[i].failure = std::current_exception();
             }
+        });
 
-            infixParser parser(tokens, symbolTable);
-            ASTNode* root = parser.infixparse();
-
-            if (root) {
-                // Print the AST in infix notation
-                std::string infixExpression = parser.printInfix(root);
-                std::cout << infixExpression << std::endl;
-                try {
-                    std::map<std::string, double> temp = symbolTable;
-                    double result = root->evaluate(temp);
-                    symbolTable = temp;
-                // Check for assignment that evaluates to a boolean value
-                Assignment* assignmentNode = dynamic_cast<Assignment*>(root);
-                if (assignmentNode && (result == 1.0 || result == 0.0)) {
-                    if (result == 1.0) {
-                        std::cout << "true" << std::endl;
-                    } else {
-                        std::cout << "false" << std::endl;
-                    }
-                } else if (dynamic_cast<BooleanNode*>(root) || (dynamic_cast<Variable*>(root) && (result == 1.0 || result == 0.0)) || (dynamic_cast<BinaryOperation*>(root) && (
-                    root->toInfix().find("<") != std::string::npos ||
-                    root->toInfix().find(">") != std::string::npos ||
-                    root->toInfix().find("==") != std::string::npos ||
-                    root->toInfix().find("!=") != std::string::npos ||
-                    root->toInfix().find("<=") != std::string::npos ||
-                    root->toInfix().find(">=") != std::string::npos ||
-                    root->toInfix().find("&") != std::string::npos ||
-                    root->toInfix().find("^") != std::string::npos ||
-                    root->toInfix().find("|") != std::string::npos))) {
-                        if (result == 1.0) {
-                            std::cout << "true" << std::endl;
-                        } else {
-                            std::cout << "false" << std::endl;
-                        }
-                } else {
-                    std::cout << result << std::endl;
-                }
-                } catch (const std::runtime_error& e) {
-                    std::cout << e.what() << std::endl;
-                }
-                delete root;
-            } else {
-                std::cout << "Failed to parse the input expression." << std::endl;
+        if (parallelEval) {
+            parallelExecutor.execute(statements, std::cout);
+        } else {
+            for (const ParsedStatement& statement : statements) {
+                executor.execute(statement, std::cout);
             }
-        } catch (const UnexpectedTokenException& e) {
-            std::cout << e.what() << std::endl;
-        } catch (const SyntaxError& e) {
-            std::cout << e.what() << std::endl;
         }
+        for (std::unique_ptr<Arena>& arena : arenas) {
+            arena->reset();
+        }
+        Stats::addLines(lines.size());
+        printRequestedStats();
+    }
+    std::cout.flush();
+    for (const std::unique_ptr<Arena>& arena : arenas) {
+        allocationStats.add(*arena);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Engine engine = Engine::TREE;
+    bool batch = false;
+    bool wholeProgram = false;
+    bool parallelEval = false;
+    bool showAllocationStats = false;
+    size_t cacheSize = DEFAULT_CACHE_SIZE;
+    bool showCacheStats = false;
+    bool showStats = false;
+    size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::string socketPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--engine=tree") {
+            engine = Engine::TREE;
+        } else if (arg == "--engine=vm") {
+            engine = Engine::VM;
+        } else if (arg == "--engine=jit") {
+            engine = Engine::JIT;
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--parallel-eval") {
+            batch = true;
+            parallelEval = true;
+        } else if (arg == "--whole-program") {
+            wholeProgram = true;
+        } else if (arg == "--alloc-stats") {
+            showAllocationStats = true;
+        } else if (arg == "--cache-size=0") {
+            cacheSize = 0;
+        } else if (arg.rfind("--cache-size=", 0) == 0 && parseCount(arg.substr(13)) > 0) {
+            cacheSize = parseCount(arg.substr(13));
+        } else if (arg == "--cache-stats") {
+            showCacheStats = true;
+        } else if (arg == "--stats") {
+            showStats = true;
+        } else if (arg.rfind("--threads=", 0) == 0 && parseCount(arg.substr(10)) > 0) {
+            threadCount = parseCount(arg.substr(10));
+        } else if (arg.rfind("--serve=", 0) == 0 && arg.size() > 8) {
+            socketPath = arg.substr(8);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--engine=tree|vm|jit] [--batch] [--parallel-eval] [--threads=N] [--whole-program]"
+                      << " [--serve=PATH] [--alloc-stats] [--cache-size=N] [--cache-stats] [--stats]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (showStats) {
+        Stats::enable();
+        std::signal(SIGUSR1, requestStats);
+    }
+
+    if (!socketPath.empty()) {
+        // Each connection has its own symbol table, so none is created here
+        std::signal(SIGINT, requestStop);
+        std::signal(SIGTERM, requestStop);
+        try {
+            Server server(socketPath, engine, cacheSize);
+            server.run(stopRequested, printRequestedStats);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        if (showStats) {
+            Stats::print(std::cerr);
+        }
+        return 0;
+    }
+
+    // Only line-by-line mode uses the statement cache
+    Interpreter interpreter(engine, wholeProgram || batch ? 0 : cacheSize);
+    AllocationStats allocationStats;
+
+    if (wholeProgram) {
+        runProgram(std::cin, interpreter.symbolTable(), interpreter.executor(), allocationStats);
+    } else if (batch) {
+        runBatch(std::cin, interpreter.symbolTable(), interpreter.executor(), engine, interpreter.liveDefinitions(),
+                 threadCount, parallelEval, allocationStats);
+    } else {
+        runLines(std::cin, interpreter, allocationStats);
+        const StatementCache* cache = interpreter.cache();
+        if (showCacheStats && cache) {
+            std::cerr << "Statement cache: " << cache->hits() << " hits, " << cache->misses() << " misses" << std::endl;
+        }
+    }
+
+    if (showAllocationStats) {
+        std::cerr << "AST nodes allocated: " << allocationStats.nodes
+                  << ", arena blocks allocated: " << allocationStats.blocks << std::endl;
+    }
+    if (showStats) {
+        Stats::print(std::cerr);
     }
     return 0;
-}
\ No newline at end of file
+}
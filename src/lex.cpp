@@ -1,27 +1,40 @@
 #include "lib/lexer.h"
+#include "lib/bufferLexer.h"
+#include "lib/mappedFile.h"
 #include "lib/token.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <string>
 
-// Main function of lexer
-int main() {
-    // Initialize the lexer with standard input (cin)
-    Lexer lexer(std::cin);
+// Print the tokens and their line and column numbers
+static void printTokens(const TokenBuffer& tokens) {
+    for (const Token& token : tokens.tokens) {
+        std::cout << std::setw(4) << std::right << token.line
+        << std::setw(5) << std::right << token.column << "  "
+        << std::left << tokens.text(token) << '\n';
+    }
+    std::cout.flush();
+}
 
+// Main function of lexer
+int main(int argc, char* argv[]) {
     try {
+        if (argc > 1) {
+            // Lex the named file in place: tokens point into the mapping instead of copying it
+            MappedFile file(argv[1]);
+            BufferLexer lexer(file.contents());
+            printTokens(lexer.tokenize());
+            return 0;
+        }
+
+        // Initialize the lexer with standard input (cin)
+        Lexer lexer(std::cin);
+
         /* Create a vector of tokens by calling the lexer's tokenize() member function which uses 
         the nextToken() helper function to create tokens and then pushes them into a vector */
 
-        std::vector<Token> tokens = lexer.tokenize();
-
-        // Print the tokens and their line and column numbers
-    for (const Token& token : tokens) {
-            std::cout << std::setw(4) << std::right << token.line 
-            << std::setw(5) << std::right << token.column << "  "
-            << std::left << token.text << std::endl;
-        }
+        printTokens(lexer.tokenize());
     }
     catch (const std::runtime_error& error) {
         // Handle syntax errors
@@ -0,0 +1,59 @@
+#include "arena.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+Arena::Arena(size_t blockSize) : blockSize(blockSize) {}
+
+Arena::~Arena() {
+    for (char* block : blocks) {
+        std::free(block);
+    }
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    uintptr_t address = (reinterpret_cast<uintptr_t>(current) + alignment - 1) & ~(alignment - 1);
+    if (current == nullptr || address + size > reinterpret_cast<uintptr_t>(end)) {
+        addBlock(size + alignment);
+        address = (reinterpret_cast<uintptr_t>(current) + alignment - 1) & ~(alignment - 1);
+    }
+    current = reinterpret_cast<char*>(address + size);
+    return reinterpret_cast<void*>(address);
+}
+
+std::string_view Arena::copyString(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    char* copy = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(copy, text.data(), text.size());
+    return std::string_view(copy, text.size());
+}
+
+void Arena::reset() {
+    if (blocks.empty()) {
+        return;
+    }
+    for (size_t i = 1; i < blocks.size(); ++i) {
+        std::free(blocks[i]);
+    }
+    blocks.resize(1);
+    current = blocks[0];
+    end = blocks[0] + blockSize;
+}
+
+void Arena::addBlock(size_t minimumSize) {
+    // Oversized requests get a block of their own; keep the first block a standard size so reset() can reuse it
+    size_t size = minimumSize > blockSize ? minimumSize : blockSize;
+    if (blocks.empty() && size != blockSize) {
+        addBlock(blockSize);
+    }
+    char* block = static_cast<char*>(std::malloc(size));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    blockCount++;
+    blocks.push_back(block);
+    current = block;
+    end = block + size;
+}
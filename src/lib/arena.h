@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Bump allocator for objects that die together, such as the nodes of one statement's tree.
+// Allocation is a pointer bump and reset() frees everything at once. Destructors are never
+// run, so objects placed here must not own heap memory of their own.
+class Arena {
+public:
+    Arena(size_t blockSize = 16 * 1024);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        objectCount++;
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Copy of text that lives as long as the arena's current contents
+    std::string_view copyString(std::string_view text);
+
+    // Drops every allocation. The first block is kept, so a reused arena stops calling malloc.
+    void reset();
+
+    // Running totals over the arena's lifetime, to compare with one heap allocation per object
+    size_t objectsAllocated() const { return objectCount; }
+    size_t blocksAllocated() const { return blockCount; }
+
+private:
+    size_t blockSize;
+    std::vector<char*> blocks;
+    char* current = nullptr;  // next free byte in blocks.back()
+    char* end = nullptr;      // end of blocks.back()
+
+    size_t objectCount = 0;
+    size_t blockCount = 0;
+
+    void addBlock(size_t minimumSize);
+};
+
+#endif
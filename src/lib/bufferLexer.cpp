@@ -0,0 +1,298 @@
+#include "bufferLexer.h"
+#include "charClass.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Runs of characters that are skipped or taken many at a time
+enum class Run {
+    BLANKS,     // CHAR_BLANK
+    DIGITS,     // CHAR_DIGIT
+    IDENTIFIER  // CHAR_IDENTIFIER
+};
+
+constexpr uint8_t classOf(Run run) {
+    return run == Run::BLANKS ? CHAR_BLANK : run == Run::DIGITS ? CHAR_DIGIT : CHAR_IDENTIFIER;
+}
+
+template <Run run>
+size_t endOfRunScalar(const char* text, size_t position, size_t size) {
+    while (position < size && isCharClass(text[position], classOf(run))) {
+        position++;
+    }
+    return position;
+}
+
+#if defined(__x86_64__)
+// The vector versions test the same classes as CHAR_CLASSES with range compares. Bytes are
+// compared as signed, so a range [low, high] is tested by moving low to -128.
+inline __m128i inRange(__m128i bytes, char low, char high) {
+    __m128i moved = _mm_add_epi8(bytes, _mm_set1_epi8(static_cast<char>(-128 - low)));
+    return _mm_cmplt_epi8(moved, _mm_set1_epi8(static_cast<char>(-128 + (high - low) + 1)));
+}
+
+// Bit i is set when byte i belongs to the run
+template <Run run>
+uint32_t runMask(__m128i bytes) {
+    __m128i mask;
+    if (run == Run::BLANKS) {
+        // ' ' and '\t' to '\r' except '\n'
+        mask = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                            _mm_andnot_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')), inRange(bytes, '\t', '\r')));
+    } else if (run == Run::DIGITS) {
+        mask = inRange(bytes, '0', '9');
+    } else {
+        // Setting bit 5 maps 'A'-'Z' onto 'a'-'z', and nothing else onto them
+        __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+        mask = _mm_or_si128(_mm_or_si128(inRange(bytes, '0', '9'), inRange(folded, 'a', 'z')),
+                            _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')));
+    }
+    return static_cast<uint32_t>(_mm_movemask_epi8(mask));
+}
+
+__attribute__((target("avx2")))
+inline __m256i inRange(__m256i bytes, char low, char high) {
+    __m256i moved = _mm256_add_epi8(bytes, _mm256_set1_epi8(static_cast<char>(-128 - low)));
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + (high - low) + 1)), moved);
+}
+
+template <Run run>
+__attribute__((target("avx2")))
+uint32_t runMask(__m256i bytes) {
+    __m256i mask;
+    if (run == Run::BLANKS) {
+        mask = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                               _mm256_andnot_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')),
+                                                   inRange(bytes, '\t', '\r')));
+    } else if (run == Run::DIGITS) {
+        mask = inRange(bytes, '0', '9');
+    } else {
+        __m256i folded = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+        mask = _mm256_or_si256(_mm256_or_si256(inRange(bytes, '0', '9'), inRange(folded, 'a', 'z')),
+                               _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')));
+    }
+    return static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+}
+
+// SSE2 is part of x86-64, so it needs no check. Loads never go past size, which may be
+// the end of a mapping.
+template <Run run>
+size_t endOfRunSse2(const char* text, size_t position, size_t size) {
+    while (position + 16 <= size) {
+        uint32_t mask = runMask<run>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position)));
+        if (mask != 0xFFFF) {
+            return position + __builtin_ctz(~mask);
+        }
+        position += 16;
+    }
+    return endOfRunScalar<run>(text, position, size);
+}
+
+template <Run run>
+__attribute__((target("avx2")))
+size_t endOfRunAvx2(const char* text, size_t position, size_t size) {
+    while (position + 32 <= size) {
+        uint32_t mask = runMask<run>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + position)));
+        if (mask != 0xFFFFFFFF) {
+            return position + __builtin_ctz(~mask);
+        }
+        position += 32;
+    }
+    return endOfRunSse2<run>(text, position, size);
+}
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+// Position of the first character at or after position that is not in the run
+template <Run run>
+size_t endOfRun(const char* text, size_t position, size_t size) {
+    // Most runs are a character or two, which the table settles without loading a vector
+    if (position + 1 >= size || !isCharClass(text[position], classOf(run))
+        || !isCharClass(text[position + 1], classOf(run))) {
+        return endOfRunScalar<run>(text, position, size);
+    }
+#if defined(__x86_64__)
+    if (hasAvx2()) {
+        return endOfRunAvx2<run>(text, position, size);
+    }
+    return endOfRunSse2<run>(text, position, size);
+#else
+    return endOfRunScalar<run>(text, position, size);
+#endif
+}
+
+}  // namespace
+
+BufferLexer::BufferLexer(std::string_view source) : source(source) {
+    tokens.source = source;
+}
+
+Token BufferLexer::nextToken() {
+    const char* text = source.data();
+    while (position < source.size()) {
+        size_t start = position;
+        unsigned char currChar = source[position++];
+        uint8_t charClass = CHAR_CLASSES[currChar];
+        if (charClass & CHAR_BLANK) {
+            // Blanks only move the column, so a whole run is skipped at once
+            position = endOfRun<Run::BLANKS>(text, position, source.size());
+            column += static_cast<int>(position - start);
+            continue;
+        }
+        if (currChar == '\n') {
+            // A line ends where END would be if it were the last one
+            int endColumn = column + 1;
+            line++;
+            column = 0;
+            tokens.lineStarts.push_back(position);
+            if (separateLines) {
+                return Token::spanning(TokenKind::NEWLINE, line - 1, endColumn, start, 1);
+            }
+            continue;
+        }
+        column++;
+
+        switch (currChar) {
+        case '(':
+            return spanning(TokenKind::LEFT_PAREN, column, start);
+        case ')':
+            return spanning(TokenKind::RIGHT_PAREN, column, start);
+        case '+':
+            return spanning(TokenKind::PLUS, column, start);
+        case '-':
+            return spanning(TokenKind::MINUS, column, start);
+        case '*':
+            return spanning(TokenKind::STAR, column, start);
+        case '/':
+            return spanning(TokenKind::SLASH, column, start);
+        case '%':
+            return spanning(TokenKind::PERCENT, column, start);
+        case '&':
+            return spanning(TokenKind::AMPERSAND, column, start);
+        case '|':
+            return spanning(TokenKind::PIPE, column, start);
+        case '^':
+            return spanning(TokenKind::CARET, column, start);
+        case '{':
+            return spanning(TokenKind::LEFT_BRACE, column, start);
+        case '}':
+            return spanning(TokenKind::RIGHT_BRACE, column, start);
+        case '=':
+            if (peek() == '=') {
+                position++;
+                column++;
+                return spanning(TokenKind::EQUAL_EQUAL, column - 1, start);
+            }
+            return spanning(TokenKind::ASSIGN, column, start);
+        case ':':
+            // ":=" declares a live definition; a lone ':' is not a token
+            if (peek() == '=') {
+                position++;
+                column++;
+                return spanning(TokenKind::LIVE_ASSIGN, column - 1, start);
+            }
+            throw SyntaxError(line, column);
+        case '<':
+        case '>':
+            if (peek() == '=') {
+                position++;
+                column++;
+                return spanning(currChar == '<' ? TokenKind::LESS_EQUAL : TokenKind::GREATER_EQUAL, column - 1, start);
+            }
+            return spanning(currChar == '<' ? TokenKind::LESS : TokenKind::GREATER, column, start);
+        case '!':
+            if (peek() == '=') {
+                position++;
+                column++;
+                return spanning(TokenKind::NOT_EQUAL, column - 1, start);
+            }
+            throw SyntaxError(line, column);
+        default:
+            break;
+        }
+
+        if (charClass & CHAR_DIGIT) {
+            bool seenDot = false;
+            while (true) {
+                size_t digitsEnd = endOfRun<Run::DIGITS>(text, position, source.size());
+                column += static_cast<int>(digitsEnd - position);
+                position = digitsEnd;
+                if (position == source.size() || source[position] != '.') {
+                    break;
+                }
+                position++;
+                // A '.' must be followed by a digit, and a number has at most one
+                if (!seenDot && !isCharClass(peek(), CHAR_DIGIT)) {
+                    throw SyntaxError(line, column + 2);
+                }
+                column++;
+                if (seenDot) {
+                    throw SyntaxError(line, column);
+                }
+                seenDot = true;
+            }
+            size_t length = position - start;
+            double value = TokenBuffer::parseNumber(source.substr(start, length));
+            return Token::numeric(value, line, column - static_cast<int>(length) + 1);
+        }
+        if (charClass & CHAR_LETTER) {
+            position = endOfRun<Run::IDENTIFIER>(text, position, source.size());
+            size_t length = position - start;
+            int startColumn = column;
+            column += static_cast<int>(length) - 1;
+            std::string_view identifier = source.substr(start, length);
+            if (identifier == "true") {
+                return spanning(TokenKind::TRUE, startColumn, start);
+            } else if (identifier == "false") {
+                return spanning(TokenKind::FALSE, startColumn, start);
+            }
+            return spanning(TokenKind::IDENTIFIER, startColumn, start);
+        }
+        throw SyntaxError(line, column);
+    }
+
+    // If you reach the end of the input, return the "END" token
+    return Token::spanning(TokenKind::END, line, column + 1, position, 0);
+}
+
+const TokenBuffer& BufferLexer::tokenize() {
+    Token currToken = nextToken();
+
+    while (currToken.kind != TokenKind::END) {
+        tokens.tokens.push_back(currToken);
+        currToken = nextToken();
+    }
+    tokens.tokens.push_back(currToken);
+
+    return tokens;
+}
+
+const TokenBuffer& BufferLexer::tokenizeLines() {
+    separateLines = true;
+    while (true) {
+        Token currToken;
+        try {
+            currToken = nextToken();
+        } catch (const SyntaxError& error) {
+            tokens.tokens.push_back(Token::spanning(TokenKind::ERROR, error.line, error.column, position, 0));
+            // Go on at the end of the line
+            size_t lineEnd = source.find('\n', position);
+            if (lineEnd == std::string_view::npos) {
+                lineEnd = source.size();
+            }
+            column += static_cast<int>(lineEnd - position);
+            position = lineEnd;
+            continue;
+        }
+        tokens.tokens.push_back(currToken);
+        if (currToken.kind == TokenKind::END) {
+            return tokens;
+        }
+    }
+}
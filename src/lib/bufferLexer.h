@@ -0,0 +1,45 @@
+#ifndef BUFFERLEXER_H
+#define BUFFERLEXER_H
+
+#include <string_view>
+#include <vector>
+#include "token.h"
+#include "lexer.h"
+
+// Lexer over a contiguous buffer, such as a MappedFile. It produces the same tokens,
+// positions and SyntaxErrors as Lexer without copying the source.
+class BufferLexer {
+public:
+    BufferLexer(std::string_view source);
+
+    // Line and column of the last character consumed, tracked like Lexer
+    int line = 1;
+    int column = 0;
+
+    // The buffer stays valid as long as the lexer and the source
+    const TokenBuffer& tokenize();
+    // Lexes every line of the source, ending each with a NEWLINE token. A SyntaxError does
+    // not stop it: the rest of that line is replaced by an ERROR token at the error.
+    const TokenBuffer& tokenizeLines();
+    Token nextToken();
+
+    // Text of a token returned by nextToken()
+    std::string_view text(const Token& token) const { return tokens.text(token); }
+
+private:
+    std::string_view source;
+    size_t position = 0;
+    TokenBuffer tokens;
+    bool separateLines = false;  // nextToken() returns NEWLINE tokens
+
+    Token spanning(TokenKind kind, int column, size_t start) const {
+        return Token::spanning(kind, line, column, start, position - start);
+    }
+
+    // Next character without consuming it, or EOF at the end of the buffer
+    int peek() const {
+        return position < source.size() ? static_cast<unsigned char>(source[position]) : EOF;
+    }
+};
+
+#endif
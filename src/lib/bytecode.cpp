@@ -0,0 +1,93 @@
+#include "bytecode.h"
+#include <map>
+#include <utility>
+
+// Opcode for each binary operator the infixParser can produce
+static const std::map<std::string, OpCode, std::less<>> binaryOpCodes = {
+    {"+", OpCode::ADD},
+    {"-", OpCode::SUB},
+    {"*", OpCode::MUL},
+    {"/", OpCode::DIV},
+    {"%", OpCode::MOD},
+    {"<", OpCode::LESS},
+    {">", OpCode::GREATER},
+    {"<=", OpCode::LESS_EQUAL},
+    {">=", OpCode::GREATER_EQUAL},
+    {"==", OpCode::EQUAL},
+    {"!=", OpCode::NOT_EQUAL},
+    {"&", OpCode::AND},
+    {"^", OpCode::XOR},
+    {"|", OpCode::OR}
+};
+
+Program BytecodeCompiler::compile(const ASTNode* root) {
+    program = Program();
+    stackDepth = 0;
+    // Post-order walk on an explicit stack: operands are emitted before their operator
+    std::vector<std::pair<const ASTNode*, bool>> pending;  // node, operands already emitted
+    pending.push_back({root, false});
+    while (!pending.empty()) {
+        auto [node, operandsDone] = pending.back();
+        pending.pop_back();
+        if (!operandsDone && node->kind == NodeKind::ASSIGNMENT) {
+            pending.push_back({node, true});
+            pending.push_back({static_cast<const Assignment*>(node)->expression, false});
+        } else if (!operandsDone && node->kind == NodeKind::BINARY_OPERATION) {
+            const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+            pending.push_back({node, true});
+            pending.push_back({binOp->right, false});
+            pending.push_back({binOp->left, false});
+        } else {
+            compileNode(node);
+        }
+    }
+    emit(OpCode::HALT);
+    return std::move(program);
+}
+
+void BytecodeCompiler::compileNode(const ASTNode* node) {
+    switch (node->kind) {
+    case NodeKind::NUMBER:
+        emit(OpCode::PUSH_CONST, addConstant(static_cast<const Number*>(node)->value));
+        return;
+    case NodeKind::BOOLEAN:
+        emit(OpCode::PUSH_CONST, addConstant(static_cast<const BooleanNode*>(node)->getValue() ? 1.0 : 0.0));
+        return;
+    case NodeKind::VARIABLE:
+        emit(OpCode::LOAD_VAR, static_cast<const Variable*>(node)->slot);
+        return;
+    case NodeKind::ASSIGNMENT:
+        emit(OpCode::STORE_VAR, static_cast<const Assignment*>(node)->slot);
+        return;
+    case NodeKind::BINARY_OPERATION: {
+        const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+        auto found = binaryOpCodes.find(binOp->op);
+        if (found == binaryOpCodes.end()) {
+            throw InvalidOperatorException();
+        }
+        // Operands rejected by inferTypes() are reported once the operands have been evaluated
+        emit(binOp->invalidOperands ? OpCode::INVALID_OPERAND : found->second);
+        return;
+    }
+    }
+    throw InvalidOperatorException();
+}
+
+void BytecodeCompiler::emit(OpCode op, int operand) {
+    program.code.emplace_back(op, operand);
+
+    if (op == OpCode::PUSH_CONST || op == OpCode::LOAD_VAR) {
+        stackDepth++;
+        if (stackDepth > program.maxStackDepth) {
+            program.maxStackDepth = stackDepth;
+        }
+    } else if (op != OpCode::STORE_VAR && op != OpCode::HALT) {
+        // Binary operators pop two operands and push one result
+        stackDepth--;
+    }
+}
+
+int BytecodeCompiler::addConstant(double value) {
+    program.constants.push_back(value);
+    return static_cast<int>(program.constants.size() - 1);
+}
@@ -0,0 +1,60 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <vector>
+#include <string>
+#include "infixParser.h"
+
+// One opcode per operator, plus the loads and stores needed to reach the symbol table
+enum class OpCode : unsigned char {
+    PUSH_CONST,       // push constants[operand]
+    LOAD_VAR,         // push the value of symbol slot operand
+    STORE_VAR,        // assign the top of the stack to symbol slot operand, leaving it on the stack
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    EQUAL,
+    NOT_EQUAL,
+    AND,
+    XOR,
+    OR,
+    INVALID_OPERAND,  // operands were rejected by the compiler: throw InvalidOperandTypeException
+    HALT
+};
+
+struct Instruction {
+    OpCode op;
+    int operand;
+
+    Instruction(OpCode op, int operand = 0) : op(op), operand(operand) {}
+};
+
+// Compiled form of a single statement
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    size_t maxStackDepth = 0;
+};
+
+// Compiler from an infixParser AST to bytecode
+class BytecodeCompiler {
+public:
+    Program compile(const ASTNode* root);
+
+private:
+    Program program;
+    size_t stackDepth = 0;
+
+    // Emits the instruction of node itself; its operands have already been emitted
+    void compileNode(const ASTNode* node);
+    void emit(OpCode op, int operand = 0);
+    int addConstant(double value);
+};
+
+#endif
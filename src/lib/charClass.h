@@ -0,0 +1,40 @@
+#ifndef CHARCLASS_H
+#define CHARCLASS_H
+
+#include <array>
+#include <cstdint>
+
+// Character classes of the lexers, looked up in one 256-entry table instead of calling
+// <cctype>. They match <cctype> in the "C" locale, which the programs never change.
+const uint8_t CHAR_BLANK = 1;       // whitespace other than '\n'
+const uint8_t CHAR_NEWLINE = 2;
+const uint8_t CHAR_DIGIT = 4;
+const uint8_t CHAR_LETTER = 8;      // letters and '_', which may start an identifier
+const uint8_t CHAR_IDENTIFIER = 16; // letters, digits and '_'
+
+constexpr std::array<uint8_t, 256> makeCharClasses() {
+    std::array<uint8_t, 256> classes{};
+    for (int c = 0; c < 256; ++c) {
+        uint8_t charClass = 0;
+        if (c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r') {
+            charClass = CHAR_BLANK;
+        } else if (c == '\n') {
+            charClass = CHAR_NEWLINE;
+        } else if (c >= '0' && c <= '9') {
+            charClass = CHAR_DIGIT | CHAR_IDENTIFIER;
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+            charClass = CHAR_LETTER | CHAR_IDENTIFIER;
+        }
+        classes[c] = charClass;
+    }
+    return classes;
+}
+
+inline constexpr std::array<uint8_t, 256> CHAR_CLASSES = makeCharClasses();
+
+// Takes a char or an int from peek(), where EOF falls in no class
+inline bool isCharClass(int c, uint8_t charClass) {
+    return CHAR_CLASSES[static_cast<unsigned char>(c)] & charClass;
+}
+
+#endif
@@ -0,0 +1,290 @@
+#include "columnEvaluator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Rows evaluated together; every operator runs over a whole block before the next one
+const size_t BLOCK_ROWS = 256;
+
+// Four doubles: one AVX register, or two SSE2 registers where AVX is not enabled.
+// aligned(8) allows loads and stores at any double boundary.
+const size_t LANES = 4;
+typedef double Doubles __attribute__((vector_size(32), aligned(8)));
+typedef int64_t Mask __attribute__((vector_size(32), aligned(8)));
+
+enum class Operator {
+    ADD, SUB, MUL, DIV, MOD,
+    LESS, GREATER, LESS_EQUAL, GREATER_EQUAL, EQUAL, NOT_EQUAL,
+    AND, XOR, OR
+};
+
+enum class StepKind {
+    CONSTANT,
+    COLUMN,
+    UNBOUND,   // variable without a column: every row fails
+    OPERATOR
+};
+
+// One node of the expression, in evaluation order. Each step fills its own block of
+// scratch values; a subtree shared by NodeTable is a single step.
+struct Step {
+    StepKind kind;
+    Operator op = Operator::ADD;
+    size_t left = 0;
+    size_t right = 0;
+    double constant = 0;
+    const double* column = nullptr;
+    bool invalidOperands = false;
+};
+
+Operator operatorFor(std::string_view op) {
+    if (op == "+") return Operator::ADD;
+    if (op == "-") return Operator::SUB;
+    if (op == "*") return Operator::MUL;
+    if (op == "/") return Operator::DIV;
+    if (op == "%") return Operator::MOD;
+    if (op == "<") return Operator::LESS;
+    if (op == ">") return Operator::GREATER;
+    if (op == "<=") return Operator::LESS_EQUAL;
+    if (op == ">=") return Operator::GREATER_EQUAL;
+    if (op == "==") return Operator::EQUAL;
+    if (op == "!=") return Operator::NOT_EQUAL;
+    if (op == "&") return Operator::AND;
+    if (op == "^") return Operator::XOR;
+    if (op == "|") return Operator::OR;
+    throw InvalidOperatorException();
+}
+
+// Appends the steps of the tree in evaluation order, operands before their operator, and
+// returns the index of the root's step. Walks an explicit stack, so depth is not limited
+// by the call stack.
+size_t flatten(const ASTNode* root, const std::vector<const double*>& columns, std::vector<Step>& steps) {
+    std::unordered_map<const ASTNode*, size_t> stepOf;
+    std::vector<std::pair<const ASTNode*, bool>> pending;  // node, operands already flattened
+    std::vector<size_t> operands;                          // step indexes, left below right
+    pending.push_back({root, false});
+    while (!pending.empty()) {
+        auto [node, operandsDone] = pending.back();
+        pending.pop_back();
+        auto found = stepOf.find(node);
+        if (found != stepOf.end()) {
+            operands.push_back(found->second);
+            continue;
+        }
+        Step step{StepKind::CONSTANT};
+        switch (node->kind) {
+        case NodeKind::NUMBER:
+            step.constant = static_cast<const Number*>(node)->value;
+            break;
+        case NodeKind::BOOLEAN:
+            step.constant = static_cast<const BooleanNode*>(node)->getValue() ? 1.0 : 0.0;
+            break;
+        case NodeKind::VARIABLE: {
+            size_t slot = static_cast<const Variable*>(node)->slot;
+            step.column = slot < columns.size() ? columns[slot] : nullptr;
+            step.kind = step.column ? StepKind::COLUMN : StepKind::UNBOUND;
+            break;
+        }
+        case NodeKind::ASSIGNMENT:
+            throw std::invalid_argument("Assignments cannot be evaluated over columns");
+        case NodeKind::BINARY_OPERATION: {
+            const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+            if (!operandsDone) {
+                pending.push_back({node, true});
+                pending.push_back({binOp->right, false});
+                pending.push_back({binOp->left, false});
+                continue;
+            }
+            step.kind = StepKind::OPERATOR;
+            step.op = operatorFor(binOp->op);
+            step.right = operands.back();
+            operands.pop_back();
+            step.left = operands.back();
+            operands.pop_back();
+            step.invalidOperands = binOp->invalidOperands;
+            break;
+        }
+        }
+        steps.push_back(step);
+        stepOf[node] = steps.size() - 1;
+        operands.push_back(steps.size() - 1);
+    }
+    return operands.back();
+}
+
+// Records error for the lanes of mask that are set, unless the row already failed
+inline __attribute__((always_inline)) void recordErrors(const Mask& mask, size_t row, size_t count,
+                                                        RowError* errors, RowError error) {
+    for (size_t lane = 0; lane < LANES && row + lane < count; ++lane) {
+        if (mask[lane] && errors[row + lane] == RowError::NONE) {
+            errors[row + lane] = error;
+        }
+    }
+}
+
+inline __attribute__((always_inline)) void recordAll(size_t count, RowError* errors, RowError error) {
+    for (size_t row = 0; row < count; ++row) {
+        if (errors[row] == RowError::NONE) {
+            errors[row] = error;
+        }
+    }
+}
+
+// Evaluates count (at most BLOCK_ROWS) rows starting at first. scratch holds BLOCK_ROWS
+// values per step; the rows past count are padding that is computed but never reported.
+inline __attribute__((always_inline)) void evaluateBlock(const std::vector<Step>& steps, size_t first, size_t count,
+                                                         double* scratch, RowError* errors) {
+    const Doubles zero = {0.0, 0.0, 0.0, 0.0};
+    const Doubles one = {1.0, 1.0, 1.0, 1.0};
+    const Mask oneBits = (Mask)one;
+
+    for (size_t s = 0; s < steps.size(); ++s) {
+        const Step& step = steps[s];
+        double* out = scratch + s * BLOCK_ROWS;
+        switch (step.kind) {
+        case StepKind::CONSTANT:
+            for (size_t row = 0; row < BLOCK_ROWS; ++row) {
+                out[row] = step.constant;
+            }
+            continue;
+        case StepKind::COLUMN:
+            std::memcpy(out, step.column + first, count * sizeof(double));
+            std::memset(out + count, 0, (BLOCK_ROWS - count) * sizeof(double));
+            continue;
+        case StepKind::UNBOUND:
+            std::memset(out, 0, BLOCK_ROWS * sizeof(double));
+            recordAll(count, errors, RowError::UNKNOWN_IDENTIFIER);
+            continue;
+        case StepKind::OPERATOR:
+            break;
+        }
+
+        const double* left = scratch + step.left * BLOCK_ROWS;
+        const double* right = scratch + step.right * BLOCK_ROWS;
+        // Operands rejected by inferTypes() fail every row, after the operands' own errors
+        if (step.invalidOperands) {
+            recordAll(count, errors, RowError::INVALID_OPERAND);
+            std::memset(out, 0, BLOCK_ROWS * sizeof(double));
+            continue;
+        }
+        if (step.op == Operator::MOD) {
+            // There is no vector fmod; it must match std::fmod exactly
+            for (size_t row = 0; row < BLOCK_ROWS; ++row) {
+                out[row] = std::fmod(left[row], right[row]);
+            }
+            continue;
+        }
+
+        for (size_t row = 0; row < BLOCK_ROWS; row += LANES) {
+            Doubles a = *reinterpret_cast<const Doubles*>(left + row);
+            Doubles b = *reinterpret_cast<const Doubles*>(right + row);
+            Doubles result;
+            switch (step.op) {
+            case Operator::ADD:
+                result = a + b;
+                break;
+            case Operator::SUB:
+                result = a - b;
+                break;
+            case Operator::MUL:
+                result = a * b;
+                break;
+            case Operator::DIV: {
+                Mask divisorIsZero = (Mask)(b == zero);
+                recordErrors(divisorIsZero, row, count, errors, RowError::DIVISION_BY_ZERO);
+                result = a / b;
+                break;
+            }
+            // Comparisons give all-ones or zero lanes, masked down to 1.0 or 0.0
+            case Operator::LESS:
+                result = (Doubles)((Mask)(a < b) & oneBits);
+                break;
+            case Operator::GREATER:
+                result = (Doubles)((Mask)(a > b) & oneBits);
+                break;
+            case Operator::LESS_EQUAL:
+                result = (Doubles)((Mask)(a <= b) & oneBits);
+                break;
+            case Operator::GREATER_EQUAL:
+                result = (Doubles)((Mask)(a >= b) & oneBits);
+                break;
+            case Operator::EQUAL:
+                result = (Doubles)((Mask)(a == b) & oneBits);
+                break;
+            case Operator::NOT_EQUAL:
+                result = (Doubles)((Mask)(a != b) & oneBits);
+                break;
+            case Operator::AND:
+            case Operator::XOR:
+            case Operator::OR: {
+                // Logical operators only accept 0 and 1; the result is +0 or 1 as with int operands
+                Mask aIsOne = (Mask)(a == one);
+                Mask bIsOne = (Mask)(b == one);
+                Mask valid = (aIsOne | (Mask)(a == zero)) & (bIsOne | (Mask)(b == zero));
+                recordErrors(~valid, row, count, errors, RowError::INVALID_OPERAND);
+                Mask truth = step.op == Operator::AND ? (aIsOne & bIsOne)
+                           : step.op == Operator::XOR ? (aIsOne ^ bIsOne)
+                           : (aIsOne | bIsOne);
+                result = (Doubles)(truth & oneBits);
+                break;
+            }
+            default:
+                result = zero;
+                break;
+            }
+            *reinterpret_cast<Doubles*>(out + row) = result;
+        }
+    }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+void evaluateBlockAvx2(const std::vector<Step>& steps, size_t first, size_t count, double* scratch, RowError* errors) {
+    evaluateBlock(steps, first, count, scratch, errors);
+}
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+void evaluateBlockDefault(const std::vector<Step>& steps, size_t first, size_t count, double* scratch, RowError* errors) {
+    evaluateBlock(steps, first, count, scratch, errors);
+}
+
+}  // namespace
+
+void evaluateColumns(const ASTNode* expression, const std::vector<const double*>& columns, size_t rows,
+                     double* results, RowError* errors) {
+    std::vector<Step> steps;
+    size_t resultStep = flatten(expression, columns, steps);
+
+    auto evaluate = evaluateBlockDefault;
+#if defined(__x86_64__)
+    if (hasAvx2()) {
+        evaluate = evaluateBlockAvx2;
+    }
+#endif
+
+    std::vector<double> scratch(steps.size() * BLOCK_ROWS);
+    const double* resultBlock = scratch.data() + resultStep * BLOCK_ROWS;
+    for (size_t first = 0; first < rows; first += BLOCK_ROWS) {
+        size_t count = rows - first < BLOCK_ROWS ? rows - first : BLOCK_ROWS;
+        RowError* blockErrors = errors + first;
+        std::fill(blockErrors, blockErrors + count, RowError::NONE);
+        evaluate(steps, first, count, scratch.data(), blockErrors);
+
+        for (size_t row = 0; row < count; ++row) {
+            results[first + row] = blockErrors[row] == RowError::NONE ? resultBlock[row]
+                                                                      : std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+}
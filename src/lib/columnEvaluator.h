@@ -0,0 +1,26 @@
+#ifndef COLUMNEVALUATOR_H
+#define COLUMNEVALUATOR_H
+
+#include <cstddef>
+#include <vector>
+#include "infixParser.h"
+
+// Why a row of evaluateColumns() has no result; the first error in evaluation order wins,
+// which is the exception the tree evaluator would have thrown for that row
+enum class RowError : unsigned char {
+    NONE = 0,
+    UNKNOWN_IDENTIFIER,
+    DIVISION_BY_ZERO,
+    INVALID_OPERAND
+};
+
+// Evaluates a pure expression once per row, for many bindings of its variables at once.
+// columns[id] holds `rows` values for the variable with symbol id `id`, or is nullptr (or
+// out of range) when that variable is unbound. The tree is evaluated operator by operator
+// over blocks of rows with SIMD kernels, using AVX2 when the CPU has it and SSE2 otherwise.
+// Rows that fail get NaN in results and their error in errors instead of throwing.
+// Throws std::invalid_argument when the expression contains an assignment.
+void evaluateColumns(const ASTNode* expression, const std::vector<const double*>& columns, size_t rows,
+                     double* results, RowError* errors);
+
+#endif
@@ -0,0 +1,132 @@
+#include "constantFolding.h"
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Value of a literal node; false when the node is not a literal
+static bool constantValue(const ASTNode* node, double& value) {
+    if (node->kind == NodeKind::NUMBER) {
+        value = static_cast<const Number*>(node)->value;
+        return true;
+    }
+    if (node->kind == NodeKind::BOOLEAN) {
+        value = static_cast<const BooleanNode*>(node)->getValue() ? 1.0 : 0.0;
+        return true;
+    }
+    return false;
+}
+
+static bool isNumber(const ASTNode* node, double value) {
+    return node->kind == NodeKind::NUMBER && static_cast<const Number*>(node)->value == value;
+}
+
+// x + 0 is not an identity: it turns -0 into 0. x - 0 is one as long as the 0 is not -0.
+static bool isPositiveZero(const ASTNode* node) {
+    return isNumber(node, 0.0) && !std::signbit(static_cast<const Number*>(node)->value);
+}
+
+static ASTNode* foldAssignment(Assignment* assignment, ASTNode* expression, Arena& arena) {
+    if (expression == assignment->expression) {
+        return assignment;
+    }
+    Assignment* folded = arena.make<Assignment>(assignment->variableName, assignment->slot, expression);
+    folded->type = assignment->type;
+    folded->live = assignment->live;
+    return folded;
+}
+
+// Folds binOp given its already folded operands
+static ASTNode* foldBinary(BinaryOperation* binOp, ASTNode* left, ASTNode* right, Arena& arena) {
+    if (!binOp->invalidOperands) {
+        double leftValue;
+        double rightValue;
+        if (constantValue(left, leftValue) && constantValue(right, rightValue)) {
+            try {
+                Number* folded = arena.make<Number>(binOp->apply(leftValue, rightValue));
+                folded->type = binOp->type;
+                return folded;
+            } catch (const std::runtime_error&) {
+                // Leave it to raise the error when the statement runs
+            }
+        }
+        if ((binOp->op == "*" || binOp->op == "/") && isNumber(right, 1.0)) {
+            return left;
+        }
+        if (binOp->op == "*" && isNumber(left, 1.0)) {
+            return right;
+        }
+        if (binOp->op == "-" && isPositiveZero(right)) {
+            return left;
+        }
+    }
+
+    if (left == binOp->left && right == binOp->right) {
+        return binOp;
+    }
+    BinaryOperation* folded = arena.make<BinaryOperation>(binOp->op, left, right);
+    folded->invalidOperands = binOp->invalidOperands;
+    folded->type = binOp->type;
+    folded->sharedSlot = binOp->sharedSlot;
+    return folded;
+}
+
+ASTNode* foldConstants(ASTNode* root, Arena& arena) {
+    if (!root) {
+        return nullptr;
+    }
+    // Post-order walk on an explicit stack. A subtree shared by NodeTable is folded once,
+    // so its parents still share the result.
+    std::vector<ASTNode*> foldedShared;
+    std::vector<std::pair<ASTNode*, bool>> pending;  // node, operands already folded
+    std::vector<ASTNode*> folded;                    // results, each operand before its parent
+    pending.push_back({root, false});
+    while (!pending.empty()) {
+        auto [node, operandsDone] = pending.back();
+        pending.pop_back();
+        size_t shared = static_cast<size_t>(node->sharedSlot);
+        if (!operandsDone) {
+            if (node->sharedSlot >= 0 && shared < foldedShared.size() && foldedShared[shared]) {
+                folded.push_back(foldedShared[shared]);
+                continue;
+            }
+            switch (node->kind) {
+            case NodeKind::NUMBER:
+            case NodeKind::BOOLEAN:
+            case NodeKind::VARIABLE:
+                folded.push_back(node);
+                continue;
+            case NodeKind::ASSIGNMENT:
+                pending.push_back({node, true});
+                pending.push_back({static_cast<Assignment*>(node)->expression, false});
+                continue;
+            case NodeKind::BINARY_OPERATION:
+                pending.push_back({node, true});
+                pending.push_back({static_cast<BinaryOperation*>(node)->right, false});
+                pending.push_back({static_cast<BinaryOperation*>(node)->left, false});
+                continue;
+            }
+        }
+
+        ASTNode* result;
+        if (node->kind == NodeKind::ASSIGNMENT) {
+            ASTNode* expression = folded.back();
+            folded.pop_back();
+            result = foldAssignment(static_cast<Assignment*>(node), expression, arena);
+        } else {
+            ASTNode* right = folded.back();
+            folded.pop_back();
+            ASTNode* left = folded.back();
+            folded.pop_back();
+            result = foldBinary(static_cast<BinaryOperation*>(node), left, right, arena);
+        }
+        if (node->sharedSlot >= 0) {
+            if (shared >= foldedShared.size()) {
+                foldedShared.resize(shared + 1, nullptr);
+            }
+            foldedShared[shared] = result;
+        }
+        folded.push_back(result);
+    }
+    return folded.back();
+}
@@ -0,0 +1,13 @@
+#ifndef CONSTANTFOLDING_H
+#define CONSTANTFOLDING_H
+
+#include "arena.h"
+#include "infixParser.h"
+
+// Returns a tree that evaluates like root but with constant subtrees replaced by their
+// values and the identities x * 1, 1 * x, x / 1 and x - 0 removed. Subtrees that would
+// throw are kept, so errors are still raised where they were. Changed nodes are
+// allocated in arena; root itself is left untouched for printing and typing.
+ASTNode* foldConstants(ASTNode* root, Arena& arena);
+
+#endif
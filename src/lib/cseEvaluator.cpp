@@ -0,0 +1,97 @@
+#include "cseEvaluator.h"
+
+double CseEvaluator::evaluate(const ASTNode* root) {
+    evaluation++;
+    // A previous call may have stopped at an exception
+    pending.clear();
+    values.clear();
+    const ASTNode* next = root;  // subtree to start, or nullptr to resume pending work
+    while (true) {
+        if (next) {
+            next = start(next);
+            continue;
+        }
+        if (pending.empty()) {
+            break;
+        }
+        Step step = pending.back();
+        pending.pop_back();
+        if (step.operandsDone) {
+            finish(step.node);
+        } else {
+            next = step.node;
+        }
+    }
+    return values.back();
+}
+
+bool CseEvaluator::isCurrent(const ASTNode* node, const CachedValue& cached) const {
+    if (cached.evaluation != evaluation) {
+        return false;
+    }
+    for (uint64_t buckets = node->reads; buckets != 0; buckets &= buckets - 1) {
+        if (writtenAt[__builtin_ctzll(buckets)] > cached.time) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const ASTNode* CseEvaluator::start(const ASTNode* node) {
+    switch (node->kind) {
+    case NodeKind::NUMBER:
+        values.push_back(static_cast<const Number*>(node)->value);
+        return nullptr;
+    case NodeKind::BOOLEAN:
+        values.push_back(static_cast<const BooleanNode*>(node)->getValue() ? 1.0 : 0.0);
+        return nullptr;
+    case NodeKind::VARIABLE: {
+        const Variable* variable = static_cast<const Variable*>(node);
+        if (!symbolTable.isDefined(variable->slot)) {
+            throw UnknownIdentifierException(variable->variableName);
+        }
+        values.push_back(symbolTable.get(variable->slot));
+        return nullptr;
+    }
+    case NodeKind::ASSIGNMENT:
+        pending.push_back({node, true});
+        return static_cast<const Assignment*>(node)->expression;
+    case NodeKind::BINARY_OPERATION: {
+        const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+        if (binOp->sharedSlot >= 0) {
+            if (static_cast<size_t>(binOp->sharedSlot) >= cache.size()) {
+                cache.resize(binOp->sharedSlot + 1);
+            }
+            if (isCurrent(binOp, cache[binOp->sharedSlot])) {
+                values.push_back(cache[binOp->sharedSlot].value);
+                return nullptr;
+            }
+        }
+        pending.push_back({node, true});
+        pending.push_back({binOp->right, false});
+        return binOp->left;
+    }
+    }
+    throw InvalidOperatorException();
+}
+
+void CseEvaluator::finish(const ASTNode* node) {
+    if (node->kind == NodeKind::ASSIGNMENT) {
+        const Assignment* assignment = static_cast<const Assignment*>(node);
+        symbolTable.set(assignment->slot, values.back());
+        writtenAt[assignment->slot % 64] = ++time;
+        return;
+    }
+    const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+    double rightValue = values.back();
+    values.pop_back();
+    double result = binOp->apply(values.back(), rightValue);
+    values.back() = result;
+    if (binOp->sharedSlot >= 0) {
+        // The subtree is pure, so time did not move while it was evaluated
+        CachedValue& cached = cache[binOp->sharedSlot];
+        cached.value = result;
+        cached.evaluation = evaluation;
+        cached.time = time;
+    }
+}
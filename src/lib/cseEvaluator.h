@@ -0,0 +1,48 @@
+#ifndef CSEEVALUATOR_H
+#define CSEEVALUATOR_H
+
+#include <cstdint>
+#include <vector>
+#include "infixParser.h"
+#include "symbolTable.h"
+
+// Tree-walking evaluator for trees built by NodeTable. A subtree with a sharedSlot is
+// computed once and its value reused at its other occurrences, until an assignment in
+// the same statement writes a variable the subtree reads. Reads are tracked per
+// bucket of slot % 64 (ASTNode::reads), so a collision only costs a recomputation.
+class CseEvaluator {
+public:
+    CseEvaluator(SymbolTable& symbolTable) : symbolTable(symbolTable) {}
+
+    double evaluate(const ASTNode* root);
+
+private:
+    struct CachedValue {
+        double value = 0;
+        uint64_t evaluation = 0;  // evaluate() call that computed value
+        uint64_t time = 0;        // assignments made before value was computed
+    };
+
+    SymbolTable& symbolTable;
+    std::vector<CachedValue> cache;  // indexed by sharedSlot
+    uint64_t evaluation = 0;
+    uint64_t time = 0;               // assignments made so far, never reset
+    uint64_t writtenAt[64] = {};     // time of the last assignment to each read bucket
+
+    // Post-order walk on an explicit stack, so depth is limited only by memory
+    struct Step {
+        const ASTNode* node;
+        bool operandsDone;
+    };
+    std::vector<Step> pending;
+    std::vector<double> values;  // results of finished subtrees, left operand below right
+
+    // Pushes node's value and returns nullptr, or schedules finish(node) after its operands
+    // and returns the operand to start next
+    const ASTNode* start(const ASTNode* node);
+    // Replaces the operand values on top of values with node's value
+    void finish(const ASTNode* node);
+    bool isCurrent(const ASTNode* node, const CachedValue& cached) const;
+};
+
+#endif
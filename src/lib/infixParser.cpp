@@ -1,50 +1,45 @@
-#include <sstream>
+#include <charconv>
 #include <stdexcept>
 #include <memory>
 #include <cmath>
 #include "infixParser.h"
+#include "typeInference.h"
+#include "cseEvaluator.h"
 
-
-std::map<std::string, double> symbolTable;
-
-Assignment::Assignment(const std::string& varName, ASTNode* expression)
-    : variableName(varName), expression(expression) {}
+Assignment::Assignment(std::string_view varName, int slot, ASTNode* expression)
+    : ASTNode(NodeKind::ASSIGNMENT), variableName(varName), slot(slot), expression(expression) {
+    pure = false;
+    reads = expression->reads;
+}
 
 
-double Assignment::evaluate(std::map<std::string, double>& symbolTable) const {
-    double result = expression->evaluate(symbolTable);
-    symbolTable[variableName] = result;
-    return result;   
+// Trees can be deeper than the call stack, so evaluate() walks them with CseEvaluator
+double Assignment::evaluate(SymbolTable& symbolTable) const {
+    return CseEvaluator(symbolTable).evaluate(this);
 }
 
-double Variable::evaluate(std::map<std::string, double>& symbolTable) const {
-    if (symbolTable.find(variableName) != symbolTable.end()) {
-            return symbolTable.at(variableName);
+double Variable::evaluate(SymbolTable& symbolTable) const {
+    if (symbolTable.isDefined(slot)) {
+            return symbolTable.get(slot);
         } else {
-            throw UnknownIdentifierException(symbolTable, variableName);
+            throw UnknownIdentifierException(variableName);
         }
 }
 
 std::string Assignment::toInfix() const {
-    return "(" + variableName + " = " + expression->toInfix() + ")";
+    std::string text;
+    appendInfix(this, text);
+    return text;
 }
 
-double BinaryOperation::evaluate(std::map<std::string, double>& symbolTable) const {
-    double leftValue = left->evaluate(symbolTable);
-    double rightValue = right->evaluate(symbolTable);
-    
-    // Type checking for arithmetic operations
-    if (op == "+" || op == "-" || op == "*" || op == "/" || op == "%") {
-        if (dynamic_cast<BooleanNode*>(left) || dynamic_cast<BooleanNode*>(right)) {
-            throw InvalidOperandTypeException();
-        }
-    }
-    // Type checking for comparison operations
-    if (op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=") {
-        if ((dynamic_cast<BooleanNode*>(left) && !dynamic_cast<BooleanNode*>(right)) || 
-            (!dynamic_cast<BooleanNode*>(left) && dynamic_cast<BooleanNode*>(right))) {
-            throw InvalidOperandTypeException();
-        }
+double BinaryOperation::evaluate(SymbolTable& symbolTable) const {
+    return CseEvaluator(symbolTable).evaluate(this);
+}
+
+double BinaryOperation::apply(double leftValue, double rightValue) const {
+    // Type checking for arithmetic and comparison operations was done by inferTypes()
+    if (invalidOperands) {
+        throw InvalidOperandTypeException();
     }
     // Type checking for logical operations
     if (op == "&" || op == "^" || op == "|") {
@@ -79,21 +74,20 @@ double BinaryOperation::evaluate(std::map<std::string, double>& symbolTable) con
 }
 
 std::string BinaryOperation::toInfix() const {
-    std::string leftStr = left->toInfix();
-    std::string rightStr = right->toInfix();
-    return "(" + leftStr + " " + op + " " + rightStr + ")";
+    std::string text;
+    appendInfix(this, text);
+    return text;
 }
 
 std::string Number::toInfix() const {
-    std::ostringstream oss;
-    oss << value;
-    std::string num = oss.str();
-    return num;
+    std::string text;
+    appendNumber(value, text);
+    return text;
 }
 
-BooleanNode::BooleanNode(bool value) : value(value) {}
+BooleanNode::BooleanNode(bool value) : ASTNode(NodeKind::BOOLEAN), value(value) {}
 
-double BooleanNode::evaluate(std::map<std::string, double>& /*unused*/) const {
+double BooleanNode::evaluate(SymbolTable& /*unused*/) const {
     return value ? 1.0 : 0.0;
 }
 
@@ -101,219 +95,236 @@ std::string BooleanNode::toInfix() const {
     return value ? "true" : "false";
 }
 
-infixParser::infixParser(const std::vector<Token>& tokens, std::map<std::string, double>& symbolTable)
-    : tokens(tokens), index(0), symbolTable(symbolTable) {
-    if (!tokens.empty()) {
-        currentToken = tokens[index];
-    }
+namespace {
+
+// Binding power of each token kind as a binary operator; 0 when it is not one. Every binary
+// operator is left-associative: its right operand only takes operators of higher power.
+constexpr unsigned char BINDING_POWER[static_cast<size_t>(TokenKind::COUNT)] = {
+    0,           // END
+    0, 0,        // ( )
+    6, 6,        // + -
+    7, 7, 7,     // * / %
+    5, 5, 5, 5,  // < > <= >=
+    4, 4,        // == !=
+    3,           // &
+    1,           // |
+    2,           // ^
+    0, 0,        // { }
+    0, 0,        // = :=
+    0, 0,        // NUMBER IDENTIFIER
+    0, 0,        // true false
+    0, 0         // NEWLINE ERROR
+};
+
+unsigned char bindingPower(TokenKind kind) {
+    return BINDING_POWER[static_cast<size_t>(kind)];
 }
 
-void infixParser::nextToken() {
-    if (index < tokens.size() - 1) {
-        index++;
-        currentToken = tokens[index];
-    } else {
-        // when END is reached
-        currentToken = Token(0, 0, "END", TokenType::OPERATOR);
-    }
-}
+}  // namespace
 
-ASTNode* infixParser::infixparse() {
-    return infixparseAssignment();
+infixParser::infixParser(const TokenBuffer& tokens, SymbolTable& symbolTable, Arena& arena)
+    : ownedTokens(std::make_unique<BufferTokenStream>(tokens)), tokens(*ownedTokens), symbolTable(symbolTable), arena(arena), nodes(arena) {
+    current = this->tokens.next();
 }
 
-ASTNode* infixParser::infixparseExpression() {
-    return infixparseAssignment();
+infixParser::infixParser(TokenStream& tokens, SymbolTable& symbolTable, Arena& arena)
+    : tokens(tokens), symbolTable(symbolTable), arena(arena), nodes(arena) {
+    current = tokens.next();
 }
 
-BinaryOperation::~BinaryOperation() {
-        delete left;
-        delete right;
-    }
-
-Assignment::~Assignment() {
-        delete expression;
-    }
-
-ASTNode* infixParser::infixparseTerm() {
-    std::unique_ptr<ASTNode> left(infixparseFactor());
-
-    while (currentToken.type == TokenType::OPERATOR && 
-      (currentToken.text == "+" || currentToken.text == "-")) {
-        std::string op = currentToken.text;
-        nextToken();  
-        std::unique_ptr<ASTNode> right(infixparseFactor());
-        left = std::make_unique<BinaryOperation>(op, left.release(), right.release());
-    }
-
-    return left.release();
-}
-
-ASTNode* infixParser::infixparseComparison() {
-    std::unique_ptr<ASTNode> left(infixparseTerm());
-
-    while (currentToken.type == TokenType::OPERATOR && 
-      (currentToken.text == "<" || currentToken.text == ">" || 
-       currentToken.text == "<=" || currentToken.text == ">=")) {
-        std::string op = currentToken.text;
-        nextToken();  
-        std::unique_ptr<ASTNode> right(infixparseTerm());
-        left = std::make_unique<BinaryOperation>(op, left.release(), right.release());
-    }
-
-    return left.release();
-}
-
-ASTNode* infixParser::infixparseLogicalAnd() {
-    std::unique_ptr<ASTNode> left(infixparseEquality());
-
-    while (currentToken.type == TokenType::OPERATOR && currentToken.text == "&") {
-        std::string op = currentToken.text;
-        nextToken();  
-        std::unique_ptr<ASTNode> right(infixparseEquality());
-        left = std::make_unique<BinaryOperation>(op, left.release(), right.release());
-    }
-
-    return left.release();
-}
-
-ASTNode* infixParser::infixparseLogicalXor() {
-    std::unique_ptr<ASTNode> left(infixparseLogicalAnd());
-
-    while (currentToken.type == TokenType::OPERATOR && currentToken.text == "^") {
-        std::string op = currentToken.text;
-        nextToken();  
-        std::unique_ptr<ASTNode> right(infixparseLogicalAnd());
-        left = std::make_unique<BinaryOperation>(op, left.release(), right.release());
+void infixParser::nextToken() {
+    consumedTokens++;
+    // the stream yields END once it is exhausted
+    if (!lookahead.empty()) {
+        current = lookahead.front();
+        lookahead.pop_front();
+    } else {
+        current = tokens.next();
     }
-
-    return left.release();
 }
 
-ASTNode* infixParser::infixparseLogicalOr() {
-    std::unique_ptr<ASTNode> left(infixparseLogicalXor());
-
-    while (currentToken.type == TokenType::OPERATOR && currentToken.text == "|") {
-        std::string op = currentToken.text;
-        nextToken();  
-        std::unique_ptr<ASTNode> right(infixparseLogicalXor());
-        left = std::make_unique<BinaryOperation>(op, left.release(), right.release());
-    }
-
-    return left.release();
+ASTNode* infixParser::infixparse() {
+    ASTNode* root = parseExpression();
+    inferTypes(root);
+    return root;
 }
 
-ASTNode* infixParser::infixparseAssignment() {
-    std::unique_ptr<ASTNode> left(infixparseLogicalOr());
-
-    while (currentToken.type == TokenType::OPERATOR && currentToken.text == "=") {
-        std::string varName = dynamic_cast<Variable*>(left.get())->variableName;
-        nextToken();  
-        std::unique_ptr<ASTNode> expr(infixparseLogicalOr());
-        left = std::make_unique<Assignment>(varName, expr.release());
+// Precedence climbing: an EXPRESSION frame collects operands joined by operators of at
+// least its minPower, and parses each right operand in a new frame that only takes
+// tighter operators. The trees, and the tokens UnexpectedTokenException reports, are those
+// of the recursive-descent grammar this replaced.
+ASTNode* infixParser::parseExpression() {
+    frames.clear();
+    frames.emplace_back(FrameKind::EXPRESSION, 1);
+    while (true) {
+        ASTNode* operand = parsePrimary();
+        if (!operand) {
+            continue;
+        }
+        // Hand the finished operand to the frames waiting for it
+        while (true) {
+            Frame& frame = frames.back();
+            if (frame.kind == FrameKind::EXPRESSION) {
+                ASTNode* left = frame.left ? nodes.binary(spellingOf(frame.op), frame.left, operand) : operand;
+                unsigned char power = bindingPower(current.kind);
+                if (power >= frame.minPower) {
+                    frame.left = left;
+                    frame.op = current.kind;
+                    nextToken();
+                    frames.emplace_back(FrameKind::EXPRESSION, power + 1);
+                    break;
+                }
+                operand = left;
+            } else if (frame.kind == FrameKind::ASSIGNED) {
+                std::string_view name;
+                int slot = symbolTable.intern(frame.name, name);
+                Assignment* assignment = arena.make<Assignment>(name, slot, operand);
+                assignment->live = frame.live;
+                operand = assignment;
+            } else {
+                if (current.kind != TokenKind::RIGHT_PAREN) {
+                    throw UnexpectedTokenException(tokens.text(current), current.line, current.column);
+                }
+                nextToken();
+            }
+            frames.pop_back();
+            if (frames.empty()) {
+                return operand;
+            }
+        }
     }
-
-    return left.release();
 }
 
-ASTNode* infixParser::infixparseEquality() {
-    std::unique_ptr<ASTNode> left(infixparseComparison());
-
-    while (currentToken.type == TokenType::OPERATOR && 
-      (currentToken.text == "==" || currentToken.text == "!=")) {
-        std::string op = currentToken.text;
-        nextToken();  
-        std::unique_ptr<ASTNode> right(infixparseComparison());
-        left = std::make_unique<BinaryOperation>(op, left.release(), right.release());
+ASTNode* infixParser::parsePrimary() {
+    switch (current.kind) {
+    case TokenKind::NUMBER: {
+        double value = current.number;
+        nextToken();
+        if (current.type() == TokenType::ASSIGNMENT) {
+            throw UnexpectedTokenException(tokens.text(current), current.line, current.column);
+        }
+        return nodes.number(value);
     }
-
-    return left.release();
-}
-
-ASTNode* infixParser::infixparseFactor() {
-    std::unique_ptr<ASTNode> left(infixparsePrimary());
-
-    while (currentToken.type == TokenType::OPERATOR && 
-      (currentToken.text == "*" || currentToken.text == "/" || currentToken.text == "%")) {
-        std::string op = currentToken.text;
-        nextToken();  
-        std::unique_ptr<ASTNode> right(infixparsePrimary());
-        left = std::make_unique<BinaryOperation>(op, left.release(), right.release());
+    case TokenKind::TRUE:
+    case TokenKind::FALSE: {
+        ASTNode* node = nodes.boolean(current.kind == TokenKind::TRUE);
+        nextToken();
+        return node;
     }
-
-    return left.release();
-}
-
-ASTNode* infixParser::infixparsePrimary() {
-    if (currentToken.type == TokenType::NUMBER) {
-        double value = std::stod(currentToken.text);
+    case TokenKind::IDENTIFIER: {
+        // A streamed token's text may move once the lexer reads on
+        variableName = tokens.text(current);
+        bool startsStatement = consumedTokens == 0;
         nextToken();
-        if (currentToken.type == TokenType::ASSIGNMENT && currentToken.text == "=") {
-            throw UnexpectedTokenException(currentToken.text, currentToken.line, currentToken.column);
+        if (current.type() != TokenType::ASSIGNMENT) {
+            std::string_view name;
+            int slot = symbolTable.intern(variableName, name);
+            return nodes.variable(name, slot);
         }
-        return std::make_unique<Number>(value).release();
-    } else if (currentToken.type == TokenType::BOOLEAN) {
-        if (currentToken.text == "true") {
-            nextToken();
-            return new BooleanNode(true);
-        } else if (currentToken.text == "false") {
-            nextToken();
-            return new BooleanNode(false);
+        // A live definition must be the whole statement
+        bool live = current.kind == TokenKind::LIVE_ASSIGN;
+        if (live && !startsStatement) {
+            throw UnexpectedTokenException(tokens.text(current), current.line, current.column);
         }
-        throw UnexpectedTokenException(currentToken.text, currentToken.line, currentToken.column);
-    } else if (currentToken.type == TokenType::IDENTIFIER) {
-        std::string varName = currentToken.text;
         nextToken();
-        if (currentToken.type == TokenType::ASSIGNMENT) {
-            nextToken();
-            std::unique_ptr<ASTNode> expr(infixparseExpression());
-            return std::make_unique<Assignment>(varName, expr.release()).release();
-        } else {
-            return std::make_unique<Variable>(varName).release();
-        }
-    } else if (currentToken.type == TokenType::LEFT_PAREN) {
+        // The variable is interned once the assigned expression has been parsed
+        frames.emplace_back(FrameKind::ASSIGNED);
+        frames.back().name = variableName;
+        frames.back().live = live;
+        frames.emplace_back(FrameKind::EXPRESSION, 1);
+        return nullptr;
+    }
+    case TokenKind::LEFT_PAREN:
         nextToken();
-        std::unique_ptr<ASTNode> result(infixparseExpression());
-        if (currentToken.type == TokenType::RIGHT_PAREN) {
-            nextToken();
-            return result.release();
-        } else {
-            throw UnexpectedTokenException(currentToken.text, currentToken.line, currentToken.column);
-        }
-    } else if (currentToken.type == TokenType::RIGHT_PAREN) {
-        throw UnexpectedTokenException(currentToken.text, currentToken.line, currentToken.column);
-    } else {
-        throw UnexpectedTokenException(currentToken.text, currentToken.line, currentToken.column);
+        frames.emplace_back(FrameKind::PARENTHESIZED);
+        frames.emplace_back(FrameKind::EXPRESSION, 1);
+        return nullptr;
+    default:
+        throw UnexpectedTokenException(tokens.text(current), current.line, current.column);
     }
 }
 
 Token infixParser::PeekNextToken() {
-    if (index < tokens.size() - 1) {
-        return tokens[index + 1];
+    if (lookahead.empty()) {
+        lookahead.push_back(tokens.next());
     }
-    return Token(0, 0, "END", TokenType::OPERATOR);
+    return lookahead.front();
 }
 
 std::string infixParser::printInfix(ASTNode* node) {
-    if (dynamic_cast<BinaryOperation*>(node) != nullptr) {
-        BinaryOperation* binOp = dynamic_cast<BinaryOperation*>(node);
-        std::string leftStr = printInfix(binOp->left);
-        std::string rightStr = printInfix(binOp->right);
-        return "(" + leftStr + " " + binOp->op + " " + rightStr + ")";
-    } else if (dynamic_cast<Number*>(node) != nullptr) {
-        std::ostringstream oss;
-        oss << dynamic_cast<Number*>(node)->value;
-        return oss.str();
-    } else if (dynamic_cast<Assignment*>(node) != nullptr) {
-        Assignment* assignment = dynamic_cast<Assignment*>(node);
-        return "(" + assignment->variableName + " = " + printInfix(assignment->expression) + ")";
-    } else if (dynamic_cast<BooleanNode*>(node) != nullptr) {
-        return dynamic_cast<BooleanNode*>(node)->toInfix();
-    } else if (dynamic_cast<Variable*>(node) != nullptr) {
-        Variable* variable = dynamic_cast<Variable*>(node);
-        return variable->variableName;
-    } else {
-        std::cout << "Invalid node type" << std::endl;
-        exit(4);
+    std::string text;
+    appendInfix(node, text);
+    return text;
+}
+
+void appendNumber(double value, std::string& out) {
+    // "%g" with six significant digits is what std::ostream prints for a double
+    char digits[32];
+    std::to_chars_result converted = std::to_chars(digits, digits + sizeof(digits), value,
+                                                   std::chars_format::general, 6);
+    out.append(digits, converted.ptr);
+}
+
+void appendInfix(const ASTNode* root, std::string& out) {
+    // Text still to write after the current subtree, in reverse order: a subtree, or
+    // literal text when node is null. An operator is written with a space on each side.
+    struct Piece {
+        const ASTNode* node;
+        std::string_view text;
+        bool isOperator;
+    };
+    // Only its capacity outlives a call
+    static thread_local std::vector<Piece> pending;
+    pending.clear();
+    const ASTNode* node = root;  // subtree to write next, or nullptr to resume pending
+    while (true) {
+        if (!node) {
+            if (pending.empty()) {
+                return;
+            }
+            Piece piece = pending.back();
+            pending.pop_back();
+            node = piece.node;
+            if (piece.isOperator) {
+                out += ' ';
+                out += piece.text;
+                out += ' ';
+            } else if (!node) {
+                out += piece.text;
+            }
+            continue;
+        }
+        switch (node->kind) {
+        case NodeKind::BINARY_OPERATION: {
+            const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+            out += '(';
+            pending.push_back({nullptr, ")", false});
+            pending.push_back({binOp->right, {}, false});
+            pending.push_back({nullptr, binOp->op, true});
+            node = binOp->left;
+            continue;
+        }
+        case NodeKind::NUMBER:
+            appendNumber(static_cast<const Number*>(node)->value, out);
+            break;
+        case NodeKind::ASSIGNMENT: {
+            const Assignment* assignment = static_cast<const Assignment*>(node);
+            out += '(';
+            out += assignment->variableName;
+            out += assignment->live ? " := " : " = ";
+            pending.push_back({nullptr, ")", false});
+            node = assignment->expression;
+            continue;
+        }
+        case NodeKind::BOOLEAN:
+            out += static_cast<const BooleanNode*>(node)->getValue() ? "true" : "false";
+            break;
+        case NodeKind::VARIABLE:
+            out += static_cast<const Variable*>(node)->variableName;
+            break;
+        default:
+            throw std::logic_error("Invalid node type");
+        }
+        node = nullptr;
     }
 }
@@ -4,37 +4,74 @@
 #include <vector>
 #include <string>
 #include <iostream>
-#include <map>
 #include <stdexcept>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <cstdint>
+#include "arena.h"
+#include "nodeTable.h"
 #include "lexer.h"
+#include "tokenStream.h"
 #include "token.h"
+#include "value.h"
+#include "symbolTable.h"
+
+// Concrete node classes, so passes can dispatch without RTTI
+enum class NodeKind {
+    NUMBER,
+    BOOLEAN,
+    VARIABLE,
+    ASSIGNMENT,
+    BINARY_OPERATION
+};
 
-// Class for node
+// Class for node. Nodes are allocated in an Arena and never own memory of their own:
+// the tree is released by resetting the arena, not by deleting the root.
 class ASTNode {
 public:
+    ASTNode(NodeKind kind) : kind(kind) {}
     virtual ~ASTNode() {}
-    virtual double evaluate(std::map<std::string, double>& symbolTable /* unused */) const = 0;
+    virtual double evaluate(SymbolTable& symbolTable) const = 0;
     virtual std::string toInfix() const = 0;
+
+    const NodeKind kind;
+    // Filled in by inferTypes() after parsing
+    ValueType type = ValueType::NUMBER;
+    // False when the subtree contains an assignment; only pure subtrees are shared by NodeTable
+    bool pure = true;
+    // Bit (slot % 64) is set for every variable the subtree reads
+    uint64_t reads = 0;
+    // Index of a BinaryOperation that occurs more than once in its statement, or -1.
+    // CseEvaluator computes such a subtree once until a variable it reads is assigned.
+    int sharedSlot = -1;
 };
 
 
 struct BinaryOperation : public ASTNode {
 public:
-    BinaryOperation(const std::string& op, ASTNode* left, ASTNode* right)
-    : op(op), left(left), right(right) {}
-    ~BinaryOperation();
-    double evaluate(std::map<std::string, double>& symbolTable /* unused */) const override;
+    BinaryOperation(std::string_view op, ASTNode* left, ASTNode* right)
+    : ASTNode(NodeKind::BINARY_OPERATION), op(op), left(left), right(right) {
+        pure = left->pure && right->pure;
+        reads = left->reads | right->reads;
+    }
+    double evaluate(SymbolTable& symbolTable) const override;
+    // Applies op to already evaluated operands, throwing the same errors as evaluate()
+    double apply(double leftValue, double rightValue) const;
     std::string toInfix() const override;
-    std::string op; 
+    std::string_view op;  // points into the arena
     ASTNode* left;
     ASTNode* right;
+    // Set by inferTypes() when a boolean literal is used where the operator does not allow it
+    bool invalidOperands = false;
 };
 
 class BooleanNode : public ASTNode {
 public:
     BooleanNode(bool value);
-    double evaluate(std::map<std::string, double>& symbolTable) const override;
+    double evaluate(SymbolTable& symbolTable) const override;
     std::string toInfix() const override;
+    bool getValue() const { return value; }
 
 private:
     bool value;
@@ -43,67 +80,104 @@ private:
 
 struct Number : public ASTNode {
 public:
-    Number(double value) : value(value) {}
-    double evaluate(std::map<std::string, double>& /* unused */) const override { return value; }
+    Number(double value) : ASTNode(NodeKind::NUMBER), value(value) {}
+    double evaluate(SymbolTable& /* unused */) const override { return value; }
     std::string toInfix() const override;
     double value;
 };
 
 
+// Appends the infix rendering of node to out in one pass, so a caller can render many
+// statements into one reused buffer
+void appendInfix(const ASTNode* node, std::string& out);
+
+// Appends value the way std::ostream prints a double ("%g": six significant digits)
+void appendNumber(double value, std::string& out);
+
+
 class infixParser {
 public:
     infixParser(const std::vector<Token>& tokens);
     std::string printInfix(ASTNode* node);
     ASTNode* infixparse();
-    infixParser(const std::vector<Token>& tokens, std::map<std::string, double>& symbolTable);
+    // Identifiers are interned into symbolTable as they are parsed, and nodes are allocated in arena.
+    // The buffer is read in place, so it must outlive the parser.
+    infixParser(const TokenBuffer& tokens, SymbolTable& symbolTable, Arena& arena);
+    // Tokens are pulled from the stream only as the parser reaches them
+    infixParser(TokenStream& tokens, SymbolTable& symbolTable, Arena& arena);
     Token PeekNextToken();
 
 private:
-    std::vector<Token> tokens;
-    size_t index;
-    Token currentToken;
-    std::map<std::string, double>& symbolTable;
+    std::unique_ptr<TokenStream> ownedTokens;  // set when constructed from a buffer
+    TokenStream& tokens;
+    std::deque<Token> lookahead;  // tokens already pulled by PeekNextToken()
+    Token current;
+    size_t consumedTokens = 0;  // tokens before current
+    SymbolTable& symbolTable;
+    Arena& arena;
+    NodeTable nodes;  // shares identical subtrees within the statement
+
+    // What a frame of the parse stack is waiting for
+    enum class FrameKind : unsigned char {
+        EXPRESSION,    // operands for binary operators of at least minPower
+        ASSIGNED,      // the expression assigned to name
+        PARENTHESIZED  // the expression before a ")"
+    };
+
+    // Operator precedence parsing keeps its frames on an explicit stack instead of the call
+    // stack, so nesting depth is limited only by memory
+    struct Frame {
+        FrameKind kind;
+        unsigned char minPower = 0;     // EXPRESSION: loosest operator this frame takes
+        TokenKind op = TokenKind::END;  // EXPRESSION: operator waiting for its right operand
+        bool live = false;              // ASSIGNED: written ":="
+        ASTNode* left = nullptr;        // EXPRESSION: left operand of op, if any
+        std::string name;               // ASSIGNED: the variable
+
+        Frame(FrameKind kind, unsigned char minPower = 0) : kind(kind), minPower(minPower) {}
+    };
+    std::vector<Frame> frames;
+    std::string variableName;  // reused copy of an identifier that is not kept in a frame
 
     void nextToken();
-    ASTNode* infixparsePrimary();
-    ASTNode* infixparseExpression();
-    ASTNode* infixparseTerm();
-    ASTNode* infixparseFactor();
-    ASTNode* infixparseAssignment();
-    ASTNode* infixparseComparison();
-    ASTNode* infixparseEquality();
-    ASTNode* infixparseLogicalAnd();
-    ASTNode* infixparseLogicalOr();
-    ASTNode* infixparseLogicalXor();
+    ASTNode* parseExpression();
+    // Parses a literal or variable; for an assignment or a parenthesized expression, pushes
+    // frames for it and returns nullptr
+    ASTNode* parsePrimary();
 };
 
 
 class Assignment : public ASTNode {
 public:
-    Assignment(const std::string& varName, ASTNode* expression);
-    ~Assignment();
-    double evaluate(std::map<std::string, double>& symbolTable /* unused */) const override;
+    Assignment(std::string_view varName, int slot, ASTNode* expression);
+    double evaluate(SymbolTable& symbolTable) const override;
     std::string toInfix() const override;
-    std::string variableName;
+    std::string_view variableName;  // points into the SymbolTable's interned names
+    int slot;  // symbol id of variableName
     ASTNode* expression;
+    // Written "name := expression": LiveDefinitions recomputes it when what it reads changes
+    bool live = false;
 };
 
 
 class Variable : public ASTNode {
 public:
-    Variable(const std::string& varName) : variableName(varName) {}
-    double evaluate(std::map<std::string, double>& symbolTable /* unused */) const override; 
+    Variable(std::string_view varName, int slot) : ASTNode(NodeKind::VARIABLE), variableName(varName), slot(slot) {
+        reads = uint64_t(1) << (slot % 64);
+    }
+    double evaluate(SymbolTable& symbolTable) const override; 
     std::string toInfix() const override {
-    return variableName;
+    return std::string(variableName);
 }
-    std::string variableName;
+    std::string_view variableName;  // points into the SymbolTable's interned names
+    int slot;  // symbol id of variableName
 };
 
 //EXCEPTION HANDLING
 class UnknownIdentifierException : public std::runtime_error{
 public:
-    UnknownIdentifierException(std::map<std::string, double>& /* unused */, const std::string& variableName)
-    : std::runtime_error("Runtime error: unknown identifier " + variableName) {}
+    UnknownIdentifierException(std::string_view variableName)
+    : std::runtime_error("Runtime error: unknown identifier " + std::string(variableName)) {}
 
     int getErrorCode() const {
     return 3;
@@ -132,8 +206,8 @@ public:
 
 class UnexpectedTokenException : public std::runtime_error {
 public:
-    UnexpectedTokenException(const std::string& tokenText, int line, int column)
-    : std::runtime_error("Unexpected token at line " + std::to_string(line) + " column " + std::to_string(column) + ": " + tokenText) {}
+    UnexpectedTokenException(std::string_view tokenText, int line, int column)
+    : std::runtime_error("Unexpected token at line " + std::to_string(line) + " column " + std::to_string(column) + ": " + std::string(tokenText)) {}
     int getErrorCode() const {
     return 2;
     }
@@ -0,0 +1,26 @@
+#include "interpreter.h"
+
+Interpreter::Interpreter(Engine engine, size_t cacheSize)
+    : statementExecutor(symbols, engine, &definitions) {
+    if (cacheSize > 0) {
+        statementCache = std::make_unique<StatementCache>(cacheSize, symbols, engine);
+    }
+}
+
+void Interpreter::execute(std::string_view line, std::ostream& out) {
+    if (statementCache) {
+        statementExecutor.execute(statementCache->parse(line), out);
+    } else {
+        parseStatement(line, symbols, arena, statement);
+        statementExecutor.execute(statement, out);
+        arena.reset();
+    }
+}
+
+size_t Interpreter::objectsAllocated() const {
+    return arena.objectsAllocated() + (statementCache ? statementCache->objectsAllocated() : 0);
+}
+
+size_t Interpreter::blocksAllocated() const {
+    return arena.blocksAllocated() + (statementCache ? statementCache->blocksAllocated() : 0);
+}
@@ -0,0 +1,47 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include "arena.h"
+#include "liveDefinitions.h"
+#include "statement.h"
+#include "statementCache.h"
+#include "symbolTable.h"
+
+// One calc session: its variables, live definitions, statement cache and the arena of the
+// line being evaluated. The library keeps no other mutable state, so any number of
+// interpreters can run in one process, each on whichever thread drives it. A single
+// interpreter is not synchronized and must be used by one thread at a time.
+class Interpreter {
+public:
+    // cacheSize is the --cache-size of the session; 0 parses every line
+    Interpreter(Engine engine, size_t cacheSize);
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    // Evaluates one line and writes what calc prints for it. Errors in the statement are
+    // part of that output; only failures of out itself escape.
+    void execute(std::string_view line, std::ostream& out);
+
+    SymbolTable& symbolTable() { return symbols; }
+    LiveDefinitions& liveDefinitions() { return definitions; }
+    StatementExecutor& executor() { return statementExecutor; }
+    // Null when the session was created without a cache
+    const StatementCache* cache() const { return statementCache.get(); }
+
+    // Allocation totals of the line arena and the cache, for --alloc-stats
+    size_t objectsAllocated() const;
+    size_t blocksAllocated() const;
+
+private:
+    SymbolTable symbols;
+    LiveDefinitions definitions{symbols};
+    StatementExecutor statementExecutor;
+    std::unique_ptr<StatementCache> statementCache;
+    Arena arena;                 // tree of the current line when there is no cache
+    ParsedStatement statement;   // reused so the rendering buffer is allocated once
+};
+
+#endif
@@ -0,0 +1,436 @@
+#include "jit.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <sys/mman.h>
+
+// Number of runs before a statement is compiled, and bounds on what is kept compiled
+static const unsigned HOT_RUNS = 2;
+static const size_t MAX_STATEMENTS = 1 << 16;
+static const size_t CHUNK_SIZE = 64 * 1024;
+// The compiler recurses once per binary operation on a path from the root; deeper trees
+// are left to the interpreter, which walks them on an explicit stack
+static const int MAX_COMPILE_NESTING = 1000;
+
+CodeBuffer::~CodeBuffer() {
+    clear();
+}
+
+void CodeBuffer::clear() {
+    for (Chunk& chunk : chunks) {
+        munmap(chunk.memory, chunk.size);
+    }
+    chunks.clear();
+}
+
+void* CodeBuffer::install(const std::vector<uint8_t>& bytes) {
+    if (chunks.empty() || chunks.back().size - chunks.back().used < bytes.size()) {
+        size_t size = bytes.size() > CHUNK_SIZE ? (bytes.size() + 4095) & ~size_t(4095) : CHUNK_SIZE;
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+        chunks.push_back({static_cast<uint8_t*>(memory), size, 0});
+    }
+    Chunk& chunk = chunks.back();
+    if (mprotect(chunk.memory, chunk.size, PROT_READ | PROT_WRITE) != 0) {
+        return nullptr;
+    }
+    uint8_t* start = chunk.memory + chunk.used;
+    std::memcpy(start, bytes.data(), bytes.size());
+    // Keep each function 16-byte aligned
+    chunk.used += (bytes.size() + 15) & ~size_t(15);
+    if (mprotect(chunk.memory, chunk.size, PROT_READ | PROT_EXEC) != 0) {
+        return nullptr;
+    }
+    return start;
+}
+
+#if defined(__x86_64__)
+
+namespace {
+
+static_assert(offsetof(SymbolTable::Slot, value) == 0, "the JIT loads slot values at offset 0");
+const int32_t SLOT_SIZE = sizeof(SymbolTable::Slot);
+const int32_t DEFINED_OFFSET = offsetof(SymbolTable::Slot, defined);
+
+// Condition codes for jcc
+enum Condition : uint8_t {
+    JE = 0x84,
+    JNE = 0x85,
+    JP = 0x8A
+};
+
+// Predicates for cmpsd; all but NEQ are false when an operand is NaN, as in C++
+enum Predicate : uint8_t {
+    CMP_EQ = 0,
+    CMP_LT = 1,
+    CMP_LE = 2,
+    CMP_NEQ = 4
+};
+
+// Emits the code of one statement. Every expression leaves its value in xmm0; a left
+// operand is spilled to the frame at [rsp + 8 * depth] while its right operand is
+// computed, unless the right operand is a leaf that can be loaded straight into xmm1.
+// rbx holds the slot array, r12 the failedSlot pointer and r13 the result pointer.
+class Assembler {
+public:
+    // Returns false when the tree uses something the JIT does not support
+    bool compile(const ASTNode* expression, std::vector<uint8_t>& out);
+
+private:
+    std::vector<uint8_t> code;
+    std::vector<size_t> exitJumps;  // rel32 fields of jumps to the epilogue
+    int maxDepth = 0;
+    int nesting = 0;  // compileNode() calls in progress for binary operations
+
+    void bytes(std::initializer_list<uint8_t> values) { code.insert(code.end(), values); }
+    void imm32(int32_t value);
+    void imm64(uint64_t value);
+    size_t jump(uint8_t condition);  // returns the offset of its rel32 field
+    void bind(size_t rel32);          // points the jump at the current position
+    void jumpToExit() { exitJumps.push_back(jump(0)); }
+    void fail(JitStatus status);
+
+    void loadConstant(int xmm, double value);
+    void loadVariable(int xmm, int slot);
+    void checkLogicalOperand(int xmm);
+    bool compileNode(const ASTNode* node, int depth);
+    bool compileOperator(const BinaryOperation* binOp);
+};
+
+void Assembler::imm32(int32_t value) {
+    uint8_t raw[4];
+    std::memcpy(raw, &value, sizeof raw);
+    code.insert(code.end(), raw, raw + sizeof raw);
+}
+
+void Assembler::imm64(uint64_t value) {
+    uint8_t raw[8];
+    std::memcpy(raw, &value, sizeof raw);
+    code.insert(code.end(), raw, raw + sizeof raw);
+}
+
+size_t Assembler::jump(uint8_t condition) {
+    if (condition == 0) {
+        bytes({0xE9});                 // jmp rel32
+    } else {
+        bytes({0x0F, condition});      // jcc rel32
+    }
+    size_t field = code.size();
+    imm32(0);
+    return field;
+}
+
+void Assembler::bind(size_t rel32) {
+    int32_t distance = static_cast<int32_t>(code.size() - (rel32 + 4));
+    std::memcpy(&code[rel32], &distance, sizeof distance);
+}
+
+void Assembler::fail(JitStatus status) {
+    bytes({0xB8});                     // mov eax, status
+    imm32(status);
+    jumpToExit();
+}
+
+void Assembler::loadConstant(int xmm, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    bytes({0x48, 0xB8});               // mov rax, imm64
+    imm64(bits);
+    bytes({0x66, 0x48, 0x0F, 0x6E, static_cast<uint8_t>(0xC0 | (xmm << 3))});  // movq xmm, rax
+}
+
+void Assembler::loadVariable(int xmm, int slot) {
+    int32_t offset = slot * SLOT_SIZE;
+    bytes({0x80, 0xBB});               // cmp byte [rbx + defined], 0
+    imm32(offset + DEFINED_OFFSET);
+    bytes({0x00});
+    size_t defined = jump(JNE);
+    bytes({0x41, 0xC7, 0x04, 0x24});   // mov dword [r12], slot
+    imm32(slot);
+    fail(JIT_UNKNOWN_IDENTIFIER);
+    bind(defined);
+    bytes({0xF2, 0x0F, 0x10, static_cast<uint8_t>(0x83 | (xmm << 3))});  // movsd xmm, [rbx + value]
+    imm32(offset);
+}
+
+// Fails unless xmm holds exactly 0 or 1; expects 0.0 in xmm2 and 1.0 in xmm3
+void Assembler::checkLogicalOperand(int xmm) {
+    uint8_t reg = static_cast<uint8_t>(0xC0 | (xmm << 3));
+    bytes({0x66, 0x0F, 0x2E, static_cast<uint8_t>(reg | 2)});  // ucomisd xmm, xmm2
+    size_t unorderedZero = jump(JP);
+    size_t isZero = jump(JE);
+    bind(unorderedZero);
+    bytes({0x66, 0x0F, 0x2E, static_cast<uint8_t>(reg | 3)});  // ucomisd xmm, xmm3
+    size_t unorderedOne = jump(JP);
+    size_t isOne = jump(JE);
+    bind(unorderedOne);
+    fail(JIT_INVALID_OPERAND);
+    bind(isZero);
+    bind(isOne);
+}
+
+bool Assembler::compileNode(const ASTNode* node, int depth) {
+    switch (node->kind) {
+    case NodeKind::NUMBER:
+        loadConstant(0, static_cast<const Number*>(node)->value);
+        return true;
+    case NodeKind::BOOLEAN:
+        loadConstant(0, static_cast<const BooleanNode*>(node)->getValue() ? 1.0 : 0.0);
+        return true;
+    case NodeKind::VARIABLE:
+        loadVariable(0, static_cast<const Variable*>(node)->slot);
+        return true;
+    case NodeKind::ASSIGNMENT:
+        // Writes must go through the symbol table's journal
+        return false;
+    case NodeKind::BINARY_OPERATION: {
+        const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+        if (++nesting > MAX_COMPILE_NESTING) {
+            return false;
+        }
+        if (!compileNode(binOp->left, depth)) {
+            return false;
+        }
+        const ASTNode* right = binOp->right;
+        if (right->kind == NodeKind::NUMBER) {
+            loadConstant(1, static_cast<const Number*>(right)->value);
+        } else if (right->kind == NodeKind::BOOLEAN) {
+            loadConstant(1, static_cast<const BooleanNode*>(right)->getValue() ? 1.0 : 0.0);
+        } else if (right->kind == NodeKind::VARIABLE) {
+            loadVariable(1, static_cast<const Variable*>(right)->slot);
+        } else {
+            if (depth + 1 > maxDepth) {
+                maxDepth = depth + 1;
+            }
+            bytes({0xF2, 0x0F, 0x11, 0x84, 0x24});  // movsd [rsp + 8 * depth], xmm0
+            imm32(8 * depth);
+            if (!compileNode(right, depth + 1)) {
+                return false;
+            }
+            bytes({0x66, 0x0F, 0x28, 0xC8});        // movapd xmm1, xmm0
+            bytes({0xF2, 0x0F, 0x10, 0x84, 0x24});  // movsd xmm0, [rsp + 8 * depth]
+            imm32(8 * depth);
+        }
+        nesting--;
+        return compileOperator(binOp);
+    }
+    }
+    return false;
+}
+
+// Applies binOp to xmm0 and xmm1, leaving the result in xmm0
+bool Assembler::compileOperator(const BinaryOperation* binOp) {
+    // Operands rejected by inferTypes() are reported once both have been evaluated
+    if (binOp->invalidOperands) {
+        fail(JIT_INVALID_OPERAND);
+        return true;
+    }
+
+    std::string_view op = binOp->op;
+    if (op == "+") {
+        bytes({0xF2, 0x0F, 0x58, 0xC1});  // addsd xmm0, xmm1
+    } else if (op == "-") {
+        bytes({0xF2, 0x0F, 0x5C, 0xC1});  // subsd xmm0, xmm1
+    } else if (op == "*") {
+        bytes({0xF2, 0x0F, 0x59, 0xC1});  // mulsd xmm0, xmm1
+    } else if (op == "/") {
+        bytes({0x66, 0x0F, 0x57, 0xD2});  // xorpd xmm2, xmm2
+        bytes({0x66, 0x0F, 0x2E, 0xCA});  // ucomisd xmm1, xmm2
+        size_t unordered = jump(JP);
+        size_t nonZero = jump(JNE);
+        fail(JIT_DIVISION_BY_ZERO);
+        bind(unordered);
+        bind(nonZero);
+        bytes({0xF2, 0x0F, 0x5E, 0xC1});  // divsd xmm0, xmm1
+    } else if (op == "%") {
+        // fmod(xmm0, xmm1); rbx, r12, r13 and the spilled operands survive the call
+        double (*fmodFunction)(double, double) = std::fmod;
+        bytes({0x48, 0xB8});              // mov rax, fmod
+        imm64(reinterpret_cast<uint64_t>(fmodFunction));
+        bytes({0xFF, 0xD0});              // call rax
+    } else if (op == "<" || op == "<=" || op == "==" || op == "!=") {
+        uint8_t predicate = op == "<" ? CMP_LT : op == "<=" ? CMP_LE : op == "==" ? CMP_EQ : CMP_NEQ;
+        bytes({0xF2, 0x0F, 0xC2, 0xC1, predicate});  // cmpsd xmm0, xmm1, predicate
+        loadConstant(2, 1.0);
+        bytes({0x66, 0x0F, 0x54, 0xC2});            // andpd xmm0, xmm2
+    } else if (op == ">" || op == ">=") {
+        // a > b is b < a, and a >= b is b <= a
+        bytes({0xF2, 0x0F, 0xC2, 0xC8, static_cast<uint8_t>(op == ">" ? CMP_LT : CMP_LE)});  // cmpsd xmm1, xmm0
+        bytes({0x66, 0x0F, 0x28, 0xC1});            // movapd xmm0, xmm1
+        loadConstant(2, 1.0);
+        bytes({0x66, 0x0F, 0x54, 0xC2});            // andpd xmm0, xmm2
+    } else if (op == "&" || op == "^" || op == "|") {
+        bytes({0x66, 0x0F, 0x57, 0xD2});            // xorpd xmm2, xmm2
+        loadConstant(3, 1.0);
+        checkLogicalOperand(0);
+        checkLogicalOperand(1);
+        bytes({0xF2, 0x0F, 0x2C, 0xC0});            // cvttsd2si eax, xmm0
+        bytes({0xF2, 0x0F, 0x2C, 0xC9});            // cvttsd2si ecx, xmm1
+        uint8_t opcode = op == "&" ? 0x21 : op == "^" ? 0x31 : 0x09;
+        bytes({opcode, 0xC8});                      // and/xor/or eax, ecx
+        bytes({0xF2, 0x0F, 0x2A, 0xC0});            // cvtsi2sd xmm0, eax
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool Assembler::compile(const ASTNode* expression, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> body;
+    code.swap(body);
+    if (!compileNode(expression, 0)) {
+        return false;
+    }
+    bytes({0xF2, 0x41, 0x0F, 0x11, 0x45, 0x00});  // movsd [r13], xmm0
+    bytes({0x31, 0xC0});                          // xor eax, eax
+    for (size_t rel32 : exitJumps) {
+        bind(rel32);
+    }
+    code.swap(body);
+
+    // The frame keeps rsp 16-byte aligned for the fmod call: three pushes after the
+    // return address already are, so the spill area is rounded up to 16 bytes
+    int32_t frame = (8 * maxDepth + 15) & ~15;
+    out.clear();
+    out.insert(out.end(), {0x53, 0x41, 0x54, 0x41, 0x55});  // push rbx; push r12; push r13
+    out.insert(out.end(), {0x48, 0x81, 0xEC});              // sub rsp, frame
+    uint8_t raw[4];
+    std::memcpy(raw, &frame, sizeof raw);
+    out.insert(out.end(), raw, raw + 4);
+    out.insert(out.end(), {0x48, 0x89, 0xFB});              // mov rbx, rdi
+    out.insert(out.end(), {0x49, 0x89, 0xD4});              // mov r12, rdx
+    out.insert(out.end(), {0x49, 0x89, 0xF5});              // mov r13, rsi
+    out.insert(out.end(), body.begin(), body.end());
+    out.insert(out.end(), {0x48, 0x81, 0xC4});              // add rsp, frame
+    out.insert(out.end(), raw, raw + 4);
+    out.insert(out.end(), {0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});  // pop r13; pop r12; pop rbx; ret
+    return true;
+}
+
+}  // namespace
+
+static bool compileStatement(const ASTNode* expression, CodeBuffer& code, JitFunction& function) {
+    Assembler assembler;
+    std::vector<uint8_t> bytes;
+    if (!assembler.compile(expression, bytes)) {
+        return false;
+    }
+    function = reinterpret_cast<JitFunction>(code.install(bytes));
+    return function != nullptr;
+}
+
+#else
+
+static bool compileStatement(const ASTNode*, CodeBuffer&, JitFunction&) {
+    return false;
+}
+
+#endif
+
+// Appends the structure of a tree to key: two trees with the same key compile to the same code
+static void appendKey(const ASTNode* root, std::string& key) {
+    // Pre-order walk on an explicit stack
+    std::vector<const ASTNode*> pending{root};
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+        key.push_back(static_cast<char>(node->kind));
+        switch (node->kind) {
+        case NodeKind::NUMBER: {
+            double value = static_cast<const Number*>(node)->value;
+            key.append(reinterpret_cast<const char*>(&value), sizeof value);
+            break;
+        }
+        case NodeKind::BOOLEAN:
+            key.push_back(static_cast<const BooleanNode*>(node)->getValue() ? 1 : 0);
+            break;
+        case NodeKind::VARIABLE: {
+            int slot = static_cast<const Variable*>(node)->slot;
+            key.append(reinterpret_cast<const char*>(&slot), sizeof slot);
+            break;
+        }
+        case NodeKind::ASSIGNMENT: {
+            const Assignment* assignment = static_cast<const Assignment*>(node);
+            key.append(reinterpret_cast<const char*>(&assignment->slot), sizeof assignment->slot);
+            pending.push_back(assignment->expression);
+            break;
+        }
+        case NodeKind::BINARY_OPERATION: {
+            const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+            key.append(binOp->op.data(), binOp->op.size());
+            key.push_back(binOp->invalidOperands ? 1 : 0);
+            pending.push_back(binOp->right);
+            pending.push_back(binOp->left);
+            break;
+        }
+        }
+    }
+}
+
+// Stores value through the assignments at the root, innermost first as Assignment::evaluate does
+static void assignInnermostFirst(const ASTNode* root, SymbolTable& symbolTable, double value) {
+    if (root->kind != NodeKind::ASSIGNMENT) {
+        return;
+    }
+    const Assignment* outer = static_cast<const Assignment*>(root);
+    if (outer->expression->kind != NodeKind::ASSIGNMENT) {
+        symbolTable.set(outer->slot, value);
+        return;
+    }
+    std::vector<int> slots;
+    for (const ASTNode* node = root; node->kind == NodeKind::ASSIGNMENT;
+         node = static_cast<const Assignment*>(node)->expression) {
+        slots.push_back(static_cast<const Assignment*>(node)->slot);
+    }
+    for (auto slot = slots.rbegin(); slot != slots.rend(); ++slot) {
+        symbolTable.set(*slot, value);
+    }
+}
+
+bool Jit::run(const ASTNode* root, SymbolTable& symbolTable, double& result) {
+    // Assignments at the root are done here, through the journal; the compiled code only
+    // evaluates the pure expression they assign
+    const ASTNode* expression = root;
+    while (expression->kind == NodeKind::ASSIGNMENT) {
+        expression = static_cast<const Assignment*>(expression)->expression;
+    }
+    if (!expression->pure) {
+        return false;
+    }
+
+    key.clear();
+    appendKey(root, key);
+    if (statements.size() >= MAX_STATEMENTS && statements.find(key) == statements.end()) {
+        statements.clear();
+        code.clear();
+    }
+    CompiledStatement& statement = statements[key];
+    if (!statement.function) {
+        if (statement.failed || ++statement.runs < HOT_RUNS) {
+            return false;
+        }
+        if (!compileStatement(expression, code, statement.function)) {
+            statement.failed = true;
+            return false;
+        }
+    }
+
+    double value = 0;
+    int failedSlot = 0;
+    switch (statement.function(symbolTable.slotData(), &value, &failedSlot)) {
+    case JIT_OK:
+        break;
+    case JIT_UNKNOWN_IDENTIFIER:
+        throw UnknownIdentifierException(symbolTable.name(failedSlot));
+    case JIT_DIVISION_BY_ZERO:
+        throw DivisionByZeroException();
+    default:
+        throw InvalidOperandTypeException();
+    }
+
+    assignInnermostFirst(root, symbolTable, value);
+    result = value;
+    return true;
+}
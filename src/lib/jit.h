@@ -0,0 +1,67 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "infixParser.h"
+#include "symbolTable.h"
+
+// Native code for one statement. It reads variables straight from the symbol table's
+// slot array and returns a JitStatus instead of throwing, leaving the value in *result
+// or the slot of an undefined variable in *failedSlot.
+using JitFunction = int (*)(const SymbolTable::Slot* slots, double* result, int* failedSlot);
+
+enum JitStatus {
+    JIT_OK = 0,
+    JIT_UNKNOWN_IDENTIFIER,
+    JIT_DIVISION_BY_ZERO,
+    JIT_INVALID_OPERAND
+};
+
+// Executable memory for compiled statements. Pages are writable only while code is
+// being copied in, and executable otherwise.
+class CodeBuffer {
+public:
+    CodeBuffer() {}
+    ~CodeBuffer();
+    CodeBuffer(const CodeBuffer&) = delete;
+    CodeBuffer& operator=(const CodeBuffer&) = delete;
+
+    // Copies code into executable memory; returns nullptr if memory could not be mapped
+    void* install(const std::vector<uint8_t>& code);
+    void clear();
+
+private:
+    struct Chunk {
+        uint8_t* memory;
+        size_t size;
+        size_t used;
+    };
+    std::vector<Chunk> chunks;
+};
+
+// Compiles statements that run often to x86-64 SSE2 code. A statement is compiled the
+// second time a tree with the same structure is run; until then, and for any tree the
+// compiler does not support (nested assignments, non-x86-64 hosts), run() returns false
+// and the caller evaluates it with the interpreter. Errors are raised as the same
+// exceptions the tree evaluator throws, in the same order.
+class Jit {
+public:
+    // Returns false when root was not run and must be interpreted instead
+    bool run(const ASTNode* root, SymbolTable& symbolTable, double& result);
+
+private:
+    struct CompiledStatement {
+        JitFunction function = nullptr;
+        unsigned runs = 0;
+        bool failed = false;  // the compiler rejected this tree
+    };
+
+    CodeBuffer code;
+    std::unordered_map<std::string, CompiledStatement> statements;  // keyed by tree structure
+    std::string key;  // reused buffer for the structural key
+};
+
+#endif
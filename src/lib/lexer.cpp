@@ -1,149 +1,176 @@
 #include "lexer.h"
 #include "token.h"
-#include <cctype>
+#include "charClass.h"
 #include <stdexcept>
 #include <cmath>
 
 // Constructor: Initializes Lexer object with input stream
 Lexer::Lexer(std::istream& input) : sExpression(input) {}
 
+bool Lexer::read(char& c) {
+    if (!sExpression.get(c)) {
+        return false;
+    }
+    source.push_back(c);
+    return true;
+}
+
+void Lexer::unread() {
+    sExpression.unget();
+    source.pop_back();
+}
+
 // Function to fetch the next token from the input stream
 Token Lexer::nextToken() {
+    Token token = scanToken();
+    // source may have moved as it grew
+    myTokens.source = source;
+    return token;
+}
+
+Token Lexer::scanToken() {
     char currChar;
 
-    while (sExpression >> std::noskipws >> currChar) {
+    while (read(currChar)) {
         if (currChar == '\n') {
             line++;
             column = 0;
+            myTokens.lineStarts.push_back(source.size());
         } else {
             column++;
         }
 
-        if (std::isspace(currChar)) {
+        if (isCharClass(currChar, CHAR_BLANK | CHAR_NEWLINE)) {
             continue;
         } else if (currChar == '(') {
-            return Token(line, column, "(", TokenType::LEFT_PAREN);
+            return spanning(TokenKind::LEFT_PAREN, column, 1);
         } else if (currChar == ')') {
-            return Token(line, column, ")", TokenType::RIGHT_PAREN);
-        } else if (currChar == '+'
-                   || currChar == '-'
-                   || currChar == '*'
-                   || currChar == '/'
-                   || currChar == '%') {
-            return Token(line, column, std::string(1, currChar), TokenType::OPERATOR);
+            return spanning(TokenKind::RIGHT_PAREN, column, 1);
+        } else if (currChar == '+') {
+            return spanning(TokenKind::PLUS, column, 1);
+        } else if (currChar == '-') {
+            return spanning(TokenKind::MINUS, column, 1);
+        } else if (currChar == '*') {
+            return spanning(TokenKind::STAR, column, 1);
+        } else if (currChar == '/') {
+            return spanning(TokenKind::SLASH, column, 1);
+        } else if (currChar == '%') {
+            return spanning(TokenKind::PERCENT, column, 1);
         } else if (currChar == '=') {
             char nextChar = sExpression.peek();
             if (nextChar == '=') {
-                sExpression.get();
+                read(nextChar);
+                column ++;
+                return spanning(TokenKind::EQUAL_EQUAL, column-1, 2);
+            } else {
+                return spanning(TokenKind::ASSIGN, column, 1);
+            }
+        } else if (currChar == ':') {
+            // ":=" declares a live definition; a lone ':' is not a token
+            char nextChar = sExpression.peek();
+            if (nextChar == '=') {
+                read(nextChar);
                 column ++;
-                return Token(line, column-1, "==", TokenType::OPERATOR);
+                return spanning(TokenKind::LIVE_ASSIGN, column-1, 2);
             } else {
-                return Token(line, column, "=", TokenType::ASSIGNMENT);
+                throw SyntaxError(line, column);
             }
         } else if (currChar == '<' || currChar == '>') {
             char nextChar = sExpression.peek();
             if (nextChar == '=') {
-                sExpression.get();
+                read(nextChar);
                 column++;
-                return Token(line, column-1, std::string(1, currChar) + "=", TokenType::OPERATOR);
+                return spanning(currChar == '<' ? TokenKind::LESS_EQUAL : TokenKind::GREATER_EQUAL, column-1, 2);
             } else {
-                return Token(line, column, std::string(1, currChar), TokenType::OPERATOR);
+                return spanning(currChar == '<' ? TokenKind::LESS : TokenKind::GREATER, column, 1);
             }
         } else if (currChar == '!') {
             char nextChar = sExpression.peek();
             if (nextChar == '=') {
-                sExpression.get();
+                read(nextChar);
                 column ++;
-                return Token(line, column-1, "!=", TokenType::OPERATOR);
+                return spanning(TokenKind::NOT_EQUAL, column-1, 2);
             } else {
                 throw SyntaxError(line, column);
             }
         } else if (currChar == '&') {
-            return Token(line, column, "&", TokenType::OPERATOR);
+            return spanning(TokenKind::AMPERSAND, column, 1);
         } else if (currChar == '|') {
-            return Token(line, column, "|", TokenType::OPERATOR);
+            return spanning(TokenKind::PIPE, column, 1);
         } else if (currChar == '^') {
-            return Token(line, column, "^", TokenType::OPERATOR);
+            return spanning(TokenKind::CARET, column, 1);
         } else if (currChar == '{') {
-            return Token(line, column, "{", TokenType::OPERATOR);
+            return spanning(TokenKind::LEFT_BRACE, column, 1);
         } else if (currChar == '}') {
-            return Token(line, column, "}", TokenType::OPERATOR);
-        }else if (std::isdigit(currChar)) {
-            std::string num;
-            num += currChar;
+            return spanning(TokenKind::RIGHT_BRACE, column, 1);
+        }else if (isCharClass(currChar, CHAR_DIGIT)) {
+            size_t start = source.size() - 1;
+            bool seenDot = false;
             char nextChar;
 
-            while (sExpression.get(nextChar)) {
-                if (std::isdigit(nextChar) || nextChar == '.') {
+            while (read(nextChar)) {
+                if (isCharClass(nextChar, CHAR_DIGIT) || nextChar == '.') {
                     // Check if the next character following a '.' is a digit
-                    if (nextChar == '.' && num.find('.') == std::string::npos) {
+                    if (nextChar == '.' && !seenDot) {
                         char followingChar = sExpression.peek();  // Peek at the next character
-                        if (!std::isdigit(followingChar)) {  // Check if it's not a digit
-                            // throw std::runtime_error("Syntax error on line " + std::to_string(line) + " column " + std::to_string(column + 2) + ".");
-                            // std::cout << "Syntax error on line " << std::to_string(line) << " column " << std::to_string(column + 2) << "." << std::endl;
-                            // exit(1);
+                        if (!isCharClass(followingChar, CHAR_DIGIT)) {  // Check if it's not a digit
                             throw SyntaxError(line, column+2);
                         }
                     }
                     column++;
 
-                      if (nextChar == '.' && num.find('.') != std::string::npos) {
-                            // throw std::runtime_error("Syntax error on line " + std::to_string(line) + " column " + std::to_string(column) + ".");
-                            // std::cout << "Syntax error on line " << std::to_string(line) << " column " << std::to_string(column) << "." << std::endl;
-                            // exit(1);
-                            throw SyntaxError(line, column);
+                    if (nextChar == '.' && seenDot) {
+                        throw SyntaxError(line, column);
                     }
-                    num += nextChar;
+                    seenDot = seenDot || nextChar == '.';
                 } else {
-                    sExpression.unget();
+                    unread();
                     break;
                 }
             }
 
-            return Token(line, (column - num.length() + 1), num, TokenType::NUMBER);
-        } else if (isalpha(currChar) || currChar == '_') {
-            std::string identifier;
-            identifier += currChar;
+            size_t length = source.size() - start;
+            double value = TokenBuffer::parseNumber(std::string_view(source).substr(start, length));
+            return Token::numeric(value, line, column - length + 1);
+        } else if (isCharClass(currChar, CHAR_LETTER)) {
+            size_t start = source.size() - 1;
             char nextChar;
 
-            while (sExpression.get(nextChar)) {
-                if (isalnum(nextChar) || nextChar == '_') {
-                    identifier += nextChar;
-                } else {
-                    sExpression.unget();
+            while (read(nextChar)) {
+                if (!isCharClass(nextChar, CHAR_IDENTIFIER)) {
+                    unread();
                     break;
                 }
             }
+            size_t length = source.size() - start;
             int tempColumn = column;
-            column += identifier.length() -1 ;
-            if (identifier == "true" || identifier == "false") {
-                return Token(line, tempColumn , identifier, TokenType::BOOLEAN);
+            column += length -1 ;
+            std::string_view identifier = std::string_view(source).substr(start, length);
+            if (identifier == "true") {
+                return Token::spanning(TokenKind::TRUE, line, tempColumn, start, length);
+            } else if (identifier == "false") {
+                return Token::spanning(TokenKind::FALSE, line, tempColumn, start, length);
             } else {
-                return Token(line, tempColumn, identifier, TokenType::IDENTIFIER);
+                return Token::spanning(TokenKind::IDENTIFIER, line, tempColumn, start, length);
             }
         } else {
-            // std::cout << "Syntax error on line " << line << " column " << column << "." << std::endl;
-            // exit(1);
             throw SyntaxError(line, column);
         }
     }
 
     // If you reach the end of the input, create and return the "END" token
-    return Token(line, column + 1, "END", TokenType::OPERATOR);
+    return Token::spanning(TokenKind::END, line, column + 1, source.size(), 0);
 }
 
-// Function to tokenize the entire input stream and return a vector of tokens
-std::vector<Token> Lexer::tokenize() {
+// Function to tokenize the entire input stream into myTokens
+const TokenBuffer& Lexer::tokenize() {
     Token currToken = nextToken();
 
-    while (currToken.text != "END") {
-        myTokens.push_back(currToken);
+    while (currToken.kind != TokenKind::END) {
+        myTokens.tokens.push_back(currToken);
         currToken = nextToken();
     }
-    // Token lastToken = myTokens[myTokens.size() - 1];
-    myTokens.push_back(currToken);
+    myTokens.tokens.push_back(currToken);
 
     return myTokens;
 }
-
-
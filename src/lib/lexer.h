@@ -3,6 +3,8 @@
 #define LEXER_H
 
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
 #include "token.h"
@@ -14,8 +16,11 @@ public:
     // Constructor declaration: takes an input stream
     Lexer(std::istream& input);
     
-    // Member variable to hold tokens
-    std::vector<Token> myTokens;
+    // Member variable to hold tokens; their spans point into source
+    TokenBuffer myTokens;
+
+    // Every character read so far
+    std::string source;
     
     // Member variable to hold the input stream
     std::istream& sExpression;
@@ -24,20 +29,36 @@ public:
     int line = 1;
     int column = 0;
     
-    // Function declaration for tokenization
-    std::vector<Token> tokenize();
+    // Function declaration for tokenization; the buffer stays valid as long as the lexer
+    const TokenBuffer& tokenize();
     
     // Function declaration for fetching the next token
     Token nextToken();
+
+    // Text of a token returned by nextToken()
+    std::string_view text(const Token& token) const { return myTokens.text(token); }
+
+private:
+    Token scanToken();
+    // Reads a character into source, or puts the last one back
+    bool read(char& c);
+    void unread();
+    // Token of length characters that ends with the last character read
+    Token spanning(TokenKind kind, int column, size_t length) const {
+        return Token::spanning(kind, line, column, source.size() - length, length);
+    }
 };
 
 class SyntaxError : public std::runtime_error {
 public:
     SyntaxError(int line, int column)
-    : std::runtime_error ("Syntax error on line " + std::to_string(line) + " column " +std::to_string(column) + ".") {}
+    : std::runtime_error ("Syntax error on line " + std::to_string(line) + " column " +std::to_string(column) + "."),
+      line(line), column(column) {}
     int getErrorCode() const {
     return 1;
     }
+    int line;
+    int column;
 };
 
 #endif
\ No newline at end of file
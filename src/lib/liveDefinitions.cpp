@@ -0,0 +1,169 @@
+#include "liveDefinitions.h"
+#include <algorithm>
+
+const Assignment* asLiveDefinition(const ASTNode* root) {
+    if (root && root->kind == NodeKind::ASSIGNMENT && static_cast<const Assignment*>(root)->live) {
+        return static_cast<const Assignment*>(root);
+    }
+    return nullptr;
+}
+
+// Adds the ids of the variables node reads, sorted and without duplicates
+static void collectReads(const ASTNode* root, std::vector<int>& reads) {
+    std::vector<const ASTNode*> pending{root};
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+        switch (node->kind) {
+        case NodeKind::NUMBER:
+        case NodeKind::BOOLEAN:
+            break;
+        case NodeKind::VARIABLE:
+            reads.push_back(static_cast<const Variable*>(node)->slot);
+            break;
+        case NodeKind::ASSIGNMENT:
+            pending.push_back(static_cast<const Assignment*>(node)->expression);
+            break;
+        case NodeKind::BINARY_OPERATION:
+            pending.push_back(static_cast<const BinaryOperation*>(node)->right);
+            pending.push_back(static_cast<const BinaryOperation*>(node)->left);
+            break;
+        }
+    }
+}
+
+static void sortUnique(std::vector<int>& ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+void LiveDefinitions::reserve() {
+    size_t size = symbolTable.size();
+    if (definitions.size() < size) {
+        definitions.resize(size);
+        dependents.resize(size);
+        parent.resize(size);
+        visited.resize(size, 0);
+    }
+}
+
+void LiveDefinitions::check(const Assignment* definition) {
+    reserve();
+    std::string name(definition->variableName);
+    if (!definition->expression->pure) {
+        throw InvalidDefinitionException("live definition of " + name + " assigns variables");
+    }
+    std::vector<int> reads;
+    collectReads(definition->expression, reads);
+    sortUnique(reads);
+    int target = definition->slot;
+    if (std::binary_search(reads.begin(), reads.end(), target)) {
+        throw InvalidDefinitionException("cyclic definition " + name + " -> " + name);
+    }
+
+    // A cycle exists when a definition downstream of target is one of the variables it reads
+    visit++;
+    visited[target] = visit;
+    std::vector<int> pending{target};
+    while (!pending.empty()) {
+        int id = pending.back();
+        pending.pop_back();
+        for (int dependent : dependents[id]) {
+            if (visited[dependent] == visit) {
+                continue;
+            }
+            visited[dependent] = visit;
+            parent[dependent] = id;
+            if (std::binary_search(reads.begin(), reads.end(), dependent)) {
+                // target reads dependent, which depends on ... which depends on target
+                std::string cycle = name;
+                for (int step = dependent; step != target; step = parent[step]) {
+                    cycle += " -> " + symbolTable.name(step);
+                }
+                throw InvalidDefinitionException("cyclic definition " + cycle + " -> " + name);
+            }
+            pending.push_back(dependent);
+        }
+    }
+}
+
+// Appends the definitions reachable from id to order, each after everything that depends on it
+void LiveDefinitions::sortAffected(int id) {
+    if (visited[id] == visit) {
+        return;
+    }
+    visited[id] = visit;
+    stack.assign(1, {id, 0});
+    while (!stack.empty()) {
+        auto& [current, next] = stack.back();
+        if (next < dependents[current].size()) {
+            int dependent = dependents[current][next++];
+            if (visited[dependent] != visit) {
+                visited[dependent] = visit;
+                stack.push_back({dependent, 0});
+            }
+        } else {
+            order.push_back(current);
+            stack.pop_back();
+        }
+    }
+}
+
+void LiveDefinitions::propagate() {
+    written.clear();
+    if (definitionCount == 0) {
+        return;
+    }
+    reserve();
+    symbolTable.collectWrites(written);
+    sortUnique(written);
+
+    order.clear();
+    visit++;
+    for (int id : written) {
+        sortAffected(id);
+    }
+    // order lists dependents before what they depend on, so run it backwards
+    for (auto id = order.rbegin(); id != order.rend(); ++id) {
+        if (std::binary_search(written.begin(), written.end(), *id) || !definitions[*id].active) {
+            continue;
+        }
+        symbolTable.set(*id, vm.run(definitions[*id].program, symbolTable));
+    }
+}
+
+void LiveDefinitions::remove(int id) {
+    for (int read : definitions[id].reads) {
+        std::vector<int>& readers = dependents[read];
+        readers.erase(std::find(readers.begin(), readers.end(), id));
+    }
+    definitions[id].active = false;
+    definitions[id].reads.clear();
+    definitionCount--;
+}
+
+void LiveDefinitions::update(const Assignment* definition) {
+    reserve();
+    for (int id : written) {
+        if (definitions[id].active && !(definition && id == definition->slot)) {
+            remove(id);
+        }
+    }
+    if (!definition) {
+        return;
+    }
+
+    int id = definition->slot;
+    if (definitions[id].active) {
+        remove(id);
+    }
+    Definition& entry = definitions[id];
+    entry.active = true;
+    entry.program = compiler.compile(definition->expression);
+    collectReads(definition->expression, entry.reads);
+    sortUnique(entry.reads);
+    for (int read : entry.reads) {
+        dependents[read].push_back(id);
+    }
+    definitionCount++;
+}
@@ -0,0 +1,75 @@
+#ifndef LIVEDEFINITIONS_H
+#define LIVEDEFINITIONS_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+#include "infixParser.h"
+#include "symbolTable.h"
+#include "vm.h"
+
+// A live definition that cannot be accepted, such as one that would form a cycle
+class InvalidDefinitionException : public std::runtime_error {
+public:
+    InvalidDefinitionException(const std::string& message)
+    : std::runtime_error("Runtime error: " + message) {}
+
+    int getErrorCode() const {
+        return 3;
+    }
+};
+
+// The live definition at the root of a statement ("name := expression"), or nullptr
+const Assignment* asLiveDefinition(const ASTNode* root);
+
+// Variables defined with ":=" keep their defining expression. The variables each one reads
+// form a dependency graph, and when a statement writes a variable, every definition that
+// depends on it, directly or through other definitions, is recomputed in topological order.
+// Only the affected definitions run, not the whole script. Assigning a defined variable
+// with "=" replaces its definition with the plain value.
+//
+// StatementExecutor drives it inside the statement's transaction: check() before the
+// statement runs, propagate() after it, and update() once it has succeeded, so a failure
+// anywhere leaves both the variables and the definitions as they were.
+class LiveDefinitions {
+public:
+    LiveDefinitions(SymbolTable& symbolTable) : symbolTable(symbolTable) {}
+
+    bool empty() const { return definitionCount == 0; }
+
+    // Throws if definition would make a variable depend on itself, or if it assigns variables
+    void check(const Assignment* definition);
+    // Recomputes the definitions that depend on the variables written so far in the transaction
+    void propagate();
+    // Records definition (if any) and drops the definitions of variables the statement assigned with "="
+    void update(const Assignment* definition);
+
+private:
+    struct Definition {
+        bool active = false;
+        Program program;         // bytecode of the defining expression
+        std::vector<int> reads;  // sorted, without duplicates
+    };
+
+    SymbolTable& symbolTable;
+    BytecodeCompiler compiler;
+    VirtualMachine vm;
+    std::vector<Definition> definitions;       // indexed by symbol id
+    std::vector<std::vector<int>> dependents;  // symbol id -> ids of the definitions that read it
+    size_t definitionCount = 0;
+
+    // Scratch state, kept to avoid allocating per statement
+    std::vector<int> written;      // ids written by the statement itself, found by propagate()
+    std::vector<int> order;
+    std::vector<std::pair<int, size_t>> stack;  // depth-first search: id and next dependent to visit
+    std::vector<int> parent;
+    std::vector<unsigned> visited;
+    unsigned visit = 0;
+
+    void reserve();
+    void remove(int id);
+    void sortAffected(int id);
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "nodeTable.h"
+#include <cstring>
+#include "infixParser.h"
+
+static uint64_t mix(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+static uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+static uint64_t hashOp(std::string_view op) {
+    uint64_t hash = 0;
+    for (char c : op) {
+        hash = hash * 31 + static_cast<unsigned char>(c);
+    }
+    return hash;
+}
+
+static uint64_t hashNumber(double value) {
+    return mix(static_cast<uint64_t>(NodeKind::NUMBER), bitsOf(value));
+}
+
+static uint64_t hashBoolean(bool value) {
+    return mix(static_cast<uint64_t>(NodeKind::BOOLEAN), value);
+}
+
+static uint64_t hashVariable(int slot) {
+    return mix(static_cast<uint64_t>(NodeKind::VARIABLE), static_cast<uint64_t>(slot));
+}
+
+static uint64_t hashBinary(std::string_view op, const ASTNode* left, const ASTNode* right) {
+    uint64_t hash = mix(static_cast<uint64_t>(NodeKind::BINARY_OPERATION), hashOp(op));
+    hash = mix(hash, reinterpret_cast<uintptr_t>(left));
+    return mix(hash, reinterpret_cast<uintptr_t>(right));
+}
+
+uint64_t NodeTable::hashOf(const ASTNode* node) {
+    switch (node->kind) {
+    case NodeKind::NUMBER:
+        return hashNumber(static_cast<const Number*>(node)->value);
+    case NodeKind::BOOLEAN:
+        return hashBoolean(static_cast<const BooleanNode*>(node)->getValue());
+    case NodeKind::VARIABLE:
+        return hashVariable(static_cast<const Variable*>(node)->slot);
+    case NodeKind::BINARY_OPERATION: {
+        const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+        return hashBinary(binOp->op, binOp->left, binOp->right);
+    }
+    case NodeKind::ASSIGNMENT:
+        break;
+    }
+    return 0;
+}
+
+template <typename Equal, typename Create>
+ASTNode* NodeTable::findOrCreate(uint64_t hash, Equal equal, Create create) {
+    if ((count + 1) * 2 > buckets.size()) {
+        grow();
+    }
+    size_t mask = buckets.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        ASTNode* node = buckets[i];
+        if (node == nullptr) {
+            node = create();
+            buckets[i] = node;
+            count++;
+            return node;
+        }
+        if (equal(node)) {
+            // Only operations are worth caching; leaves are shared so their parents compare equal
+            if (node->kind == NodeKind::BINARY_OPERATION && node->sharedSlot < 0) {
+                node->sharedSlot = nextSharedSlot++;
+            }
+            return node;
+        }
+    }
+}
+
+void NodeTable::grow() {
+    std::vector<ASTNode*> old = std::move(buckets);
+    buckets.assign(old.empty() ? 64 : old.size() * 2, nullptr);
+    size_t mask = buckets.size() - 1;
+    for (ASTNode* node : old) {
+        if (node) {
+            size_t i = hashOf(node) & mask;
+            while (buckets[i]) {
+                i = (i + 1) & mask;
+            }
+            buckets[i] = node;
+        }
+    }
+}
+
+ASTNode* NodeTable::number(double value) {
+    return findOrCreate(hashNumber(value),
+        [&](const ASTNode* node) {
+            return node->kind == NodeKind::NUMBER && bitsOf(static_cast<const Number*>(node)->value) == bitsOf(value);
+        },
+        [&] { return arena.make<Number>(value); });
+}
+
+ASTNode* NodeTable::boolean(bool value) {
+    return findOrCreate(hashBoolean(value),
+        [&](const ASTNode* node) {
+            return node->kind == NodeKind::BOOLEAN && static_cast<const BooleanNode*>(node)->getValue() == value;
+        },
+        [&] { return arena.make<BooleanNode>(value); });
+}
+
+ASTNode* NodeTable::variable(std::string_view name, int slot) {
+    return findOrCreate(hashVariable(slot),
+        [&](const ASTNode* node) {
+            return node->kind == NodeKind::VARIABLE && static_cast<const Variable*>(node)->slot == slot;
+        },
+        [&] { return arena.make<Variable>(name, slot); });
+}
+
+ASTNode* NodeTable::binary(std::string_view op, ASTNode* left, ASTNode* right) {
+    if (!left->pure || !right->pure) {
+        return arena.make<BinaryOperation>(arena.copyString(op), left, right);
+    }
+    return findOrCreate(hashBinary(op, left, right),
+        [&](const ASTNode* node) {
+            const BinaryOperation* binOp = static_cast<const BinaryOperation*>(node);
+            return node->kind == NodeKind::BINARY_OPERATION && binOp->left == left && binOp->right == right && binOp->op == op;
+        },
+        [&] { return arena.make<BinaryOperation>(arena.copyString(op), left, right); });
+}
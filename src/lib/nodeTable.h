@@ -0,0 +1,41 @@
+#ifndef NODETABLE_H
+#define NODETABLE_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+class ASTNode;
+
+// Hash-consing table for the nodes of one statement. Leaves and pure binary operations
+// are looked up before they are created, so structurally identical subtrees become one
+// node and the tree becomes a DAG. Children are already unique, so two binary operations
+// are equal when their operators and child pointers are. A binary operation that is found
+// again gets a sharedSlot for CseEvaluator. Subtrees containing an assignment are never shared.
+class NodeTable {
+public:
+    NodeTable(Arena& arena) : arena(arena) {}
+
+    ASTNode* number(double value);
+    ASTNode* boolean(bool value);
+    ASTNode* variable(std::string_view name, int slot);
+    // op is copied into the arena when a new node is created
+    ASTNode* binary(std::string_view op, ASTNode* left, ASTNode* right);
+
+    // Number of binary operations that occur more than once
+    int sharedCount() const { return nextSharedSlot; }
+
+private:
+    Arena& arena;
+    std::vector<ASTNode*> buckets;  // open addressing, power-of-two size, nullptr when empty
+    size_t count = 0;
+    int nextSharedSlot = 0;
+
+    template <typename Equal, typename Create>
+    ASTNode* findOrCreate(uint64_t hash, Equal equal, Create create);
+    void grow();
+    static uint64_t hashOf(const ASTNode* node);
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "parallelExecutor.h"
+#include <algorithm>
+#include <exception>
+#include <sstream>
+#include "stats.h"
+
+// Adds the slots a tree reads and writes to reads and writes
+static void collectAccesses(const ASTNode* root, std::vector<int>& reads, std::vector<int>& writes) {
+    std::vector<const ASTNode*> pending{root};
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+        switch (node->kind) {
+        case NodeKind::NUMBER:
+        case NodeKind::BOOLEAN:
+            break;
+        case NodeKind::VARIABLE:
+            reads.push_back(static_cast<const Variable*>(node)->slot);
+            break;
+        case NodeKind::ASSIGNMENT:
+            writes.push_back(static_cast<const Assignment*>(node)->slot);
+            pending.push_back(static_cast<const Assignment*>(node)->expression);
+            break;
+        case NodeKind::BINARY_OPERATION:
+            pending.push_back(static_cast<const BinaryOperation*>(node)->right);
+            pending.push_back(static_cast<const BinaryOperation*>(node)->left);
+            break;
+        }
+    }
+}
+
+static void sortUnique(std::vector<int>& slots) {
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+}
+
+ParallelExecutor::ParallelExecutor(SymbolTable& symbolTable, Engine engine, ThreadPool& pool, LiveDefinitions* liveDefinitions)
+    : symbolTable(symbolTable), pool(pool), liveDefinitions(liveDefinitions) {
+    for (size_t i = 0; i < pool.size(); ++i) {
+        executors.push_back(std::make_unique<StatementExecutor>(symbolTable, engine, liveDefinitions));
+    }
+}
+
+TaskGraph ParallelExecutor::buildGraph(const std::vector<std::vector<int>>& reads, const std::vector<std::vector<int>>& writes) {
+    TaskGraph graph(reads.size());
+    lastWriter.resize(symbolTable.size(), -1);
+    readersSinceWrite.resize(symbolTable.size());
+
+    for (size_t i = 0; i < reads.size(); ++i) {
+        // Read after write
+        for (int slot : reads[i]) {
+            if (lastWriter[slot] >= 0) {
+                graph.addDependency(lastWriter[slot], i);
+            }
+        }
+        // Write after write, and write after read
+        for (int slot : writes[i]) {
+            if (lastWriter[slot] >= 0) {
+                graph.addDependency(lastWriter[slot], i);
+            }
+            for (size_t reader : readersSinceWrite[slot]) {
+                if (reader != i) {
+                    graph.addDependency(reader, i);
+                }
+            }
+        }
+
+        for (int slot : writes[i]) {
+            lastWriter[slot] = static_cast<long>(i);
+            readersSinceWrite[slot].clear();
+        }
+        for (int slot : reads[i]) {
+            if (!std::binary_search(writes[i].begin(), writes[i].end(), slot)) {
+                readersSinceWrite[slot].push_back(i);
+            }
+        }
+    }
+
+    // Reset only the slots this block touched
+    for (size_t i = 0; i < reads.size(); ++i) {
+        for (int slot : writes[i]) {
+            lastWriter[slot] = -1;
+        }
+        for (int slot : reads[i]) {
+            readersSinceWrite[slot].clear();
+        }
+    }
+    return graph;
+}
+
+void ParallelExecutor::execute(const std::vector<ParsedStatement>& statements, std::ostream& out) {
+    if (liveDefinitions) {
+        bool live = !liveDefinitions->empty();
+        for (size_t i = 0; i < statements.size() && !live; ++i) {
+            live = asLiveDefinition(statements[i].optimized) != nullptr;
+        }
+        if (live) {
+            for (const ParsedStatement& statement : statements) {
+                executors[0]->execute(statement, out);
+            }
+            return;
+        }
+    }
+
+    size_t count = statements.size();
+    std::vector<std::vector<int>> reads(count);
+    std::vector<std::vector<int>> writes(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (statements[i].root) {
+            collectAccesses(statements[i].optimized, reads[i], writes[i]);
+            sortUnique(reads[i]);
+            sortUnique(writes[i]);
+        }
+    }
+    TaskGraph graph = buildGraph(reads, writes);
+
+    std::vector<std::string> outputs(count);
+    std::vector<std::exception_ptr> failures(count);
+    graph.execute(pool, [&](size_t i, size_t thread) {
+        const ParsedStatement& statement = statements[i];
+        if (statement.failure) {
+            failures[i] = statement.failure;
+            return;
+        }
+        std::ostringstream output;
+        output << statement.text << '\n';
+        if (statement.root) {
+            // Only this statement touches its write set while it runs, so saving those
+            // slots is enough to undo it
+            std::vector<SymbolTable::Slot> saved;
+            for (int slot : writes[i]) {
+                saved.push_back(symbolTable.slot(slot));
+            }
+            try {
+                double result;
+                {
+                    ScopedPhaseTimer timer(Phase::EVALUATE);
+                    result = executors[thread]->evaluate(statement.optimized);
+                }
+                output << Value::fromResult(statement.root->type, result) << '\n';
+            } catch (...) {
+                for (size_t k = 0; k < saved.size(); ++k) {
+                    symbolTable.restore(writes[i][k], saved[k]);
+                }
+                try {
+                    throw;
+                } catch (const std::runtime_error& e) {
+                    Stats::countException(e);
+                    output << e.what() << '\n';
+                } catch (...) {
+                    failures[i] = std::current_exception();
+                }
+            }
+        }
+        outputs[i] = output.str();
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+        out << outputs[i];
+        if (failures[i]) {
+            out.flush();
+            std::rethrow_exception(failures[i]);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef PARALLELEXECUTOR_H
+#define PARALLELEXECUTOR_H
+
+#include <vector>
+#include <memory>
+#include <iostream>
+#include "statement.h"
+#include "taskGraph.h"
+#include "threadPool.h"
+
+// Evaluates a block of parsed statements concurrently. Each statement's read and write
+// sets come from its Variable and Assignment nodes; statements that touch a common
+// variable, where at least one of them writes it, run in source order. Everything else
+// runs in parallel. Output is printed in source order and matches StatementExecutor,
+// including undoing the writes of a statement that fails. Once live definitions are in
+// play, a write can recompute variables the graph does not know about, so such blocks
+// run in order on one thread.
+class ParallelExecutor {
+public:
+    ParallelExecutor(SymbolTable& symbolTable, Engine engine, ThreadPool& pool, LiveDefinitions* liveDefinitions = nullptr);
+
+    void execute(const std::vector<ParsedStatement>& statements, std::ostream& out);
+
+private:
+    SymbolTable& symbolTable;
+    ThreadPool& pool;
+    LiveDefinitions* liveDefinitions;
+    std::vector<std::unique_ptr<StatementExecutor>> executors;  // one per pool thread
+
+    // Per-slot bookkeeping while the dependency graph is built, reused between blocks
+    std::vector<long> lastWriter;
+    std::vector<std::vector<size_t>> readersSinceWrite;
+
+    TaskGraph buildGraph(const std::vector<std::vector<int>>& reads, const std::vector<std::vector<int>>& writes);
+};
+
+#endif
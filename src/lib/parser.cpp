@@ -1,23 +1,40 @@
 #include "parser.h"
-#include <iostream>
 #include <sstream>
 #include <cmath>
+#include <stdexcept>
+#include "infixParser.h"
 
-std::unordered_map<std::string, double> Node::variableMap;
-
-Node::~Node() {
-    for (Node* child : children) {
-        delete child;
+void Node::addChild(Node* child) {
+    if (lastChild) {
+        lastChild->nextSibling = child;
+    } else {
+        firstChild = child;
     }
+    lastChild = child;
+    childCount++;
+}
+
+Parser::Parser(const TokenBuffer& tokens, Arena& arena)
+    : ownedTokens(std::make_unique<BufferTokenStream>(tokens)), tokens(*ownedTokens), arena(arena) {
+    currentToken = this->tokens.next();
+}
+
+Parser::Parser(TokenStream& tokens, Arena& arena) : tokens(tokens), arena(arena) {
+    currentToken = tokens.next();
 }
 
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens), currentTokenIndex(0) {}
+void Parser::nextToken() {
+    if (currentToken.kind == TokenKind::END) {
+        exhausted = true;
+    }
+    currentToken = tokens.next();
+}
 
 Parser::~Parser() {
 }
 
 std::vector<Node*> Parser::parse() {
-    while (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].text != "END") {
+    while (!exhausted && currentToken.kind != TokenKind::END) {
         auto root = parseExpression();
         roots.push_back(root);
     }
@@ -25,78 +42,45 @@ std::vector<Node*> Parser::parse() {
 }
 
 Node* Parser::parseExpression() {
-    Node* node = new Node("");
-    while (currentTokenIndex < tokens.size()) {
-        if (tokens[currentTokenIndex].type == TokenType::LEFT_PAREN) {
-            currentTokenIndex++;
-            std::string next_token = tokens[currentTokenIndex].text;
-
-            if (next_token != "+" && next_token != "-" && next_token != "*" && next_token != "/" && next_token != "=") {
-                if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == TokenType::RIGHT_PAREN) {
-                    std::cout << "Unexpected token at line " << tokens[currentTokenIndex].line
-                              << " column " << tokens[currentTokenIndex].column
-                              << ": " << tokens[currentTokenIndex].text << std::endl;
-                } else {
-                    std::cout << "Unexpected token at line " << tokens[currentTokenIndex].line
-                              << " column " << tokens[currentTokenIndex].column
-                              << ": " << tokens[currentTokenIndex].text << std::endl;
-                }
-                exit(2);
+    Node* node = arena.make<Node>("");
+    while (!exhausted) {
+        if (currentToken.kind == TokenKind::LEFT_PAREN) {
+            nextToken();
+            TokenKind next_token = currentToken.kind;
+
+            if (next_token != TokenKind::PLUS && next_token != TokenKind::MINUS && next_token != TokenKind::STAR
+                && next_token != TokenKind::SLASH && next_token != TokenKind::ASSIGN) {
+                throw UnexpectedTokenException(tokens.text(currentToken), currentToken.line, currentToken.column);
             }
-            node->type = tokens[currentTokenIndex].type;
-            node->value = tokens[currentTokenIndex++].text;
+            node->type = currentToken.type();
+            node->value = arena.copyString(tokens.text(currentToken));
+            nextToken();
 
-            while (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type != TokenType::RIGHT_PAREN) {
-                node->children.push_back(parseExpression());
+            while (!exhausted && currentToken.kind != TokenKind::RIGHT_PAREN) {
+                node->addChild(parseExpression());
             }
-            if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == TokenType::RIGHT_PAREN) {
-                currentTokenIndex++;
+            if (!exhausted && currentToken.kind == TokenKind::RIGHT_PAREN) {
+                nextToken();
                 if (node->type == TokenType::ASSIGNMENT) {
-                    // Check for unexpected token cases in assignment
-                    if (node->children.empty()) {
-                        std::cout << "Unexpected token at line " << tokens[currentTokenIndex].line
-                                  << " column " << tokens[currentTokenIndex].column
-                                  << ": " << tokens[currentTokenIndex].text << std::endl;
-                        exit(2);
-                    } else if (node->children.size() == 1) {
-                        std::cout << "Unexpected token at line " << tokens[currentTokenIndex].line
-                                  << " column " << tokens[currentTokenIndex].column
-                                  << ": " << tokens[currentTokenIndex].text << std::endl;
-                        exit(2);
+                    // An assignment needs a variable and a value
+                    if (node->childCount < 2) {
+                        throw UnexpectedTokenException(tokens.text(currentToken), currentToken.line, currentToken.column);
                     }
                 }
                 return node;
             } else {
-                if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == TokenType::RIGHT_PAREN) {
-                    std::cout << "Unexpected token at line " << tokens[currentTokenIndex].line
-                              << " column " << tokens[currentTokenIndex].column
-                              << ": " << tokens[currentTokenIndex].text << std::endl;
-                } else {
-                    std::cout << "Unexpected token at line " << tokens[currentTokenIndex].line
-                              << " column " << tokens[currentTokenIndex].column
-                              << ": " << tokens[currentTokenIndex].text << std::endl;
-                }
-                exit(2);
+                throw UnexpectedTokenException(tokens.text(currentToken), currentToken.line, currentToken.column);
             }
-        } else if (tokens[currentTokenIndex].type == TokenType::NUMBER || tokens[currentTokenIndex].type == TokenType::IDENTIFIER || tokens[currentTokenIndex].type == TokenType::ASSIGNMENT) {
-            node->type = tokens[currentTokenIndex].type;
-            node->value = tokens[currentTokenIndex++].text;
+        } else if (currentToken.kind == TokenKind::NUMBER || currentToken.kind == TokenKind::IDENTIFIER || currentToken.type() == TokenType::ASSIGNMENT) {
+            node->type = currentToken.type();
+            node->value = arena.copyString(tokens.text(currentToken));
+            nextToken();
             return node;
         } else {
-            if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == TokenType::RIGHT_PAREN) {
-               std::cout << "Unexpected token at line " << tokens[currentTokenIndex].line
-                          << " column " << tokens[currentTokenIndex].column
-                          << ": " << tokens[currentTokenIndex].text << std::endl;
-            } else {
-                std::cout << "Unexpected token at line " << tokens[currentTokenIndex].line
-                          << " column " << tokens[currentTokenIndex].column
-                          << ": " << tokens[currentTokenIndex].text << std::endl;
-            }
-            exit(2);
+            throw UnexpectedTokenException(tokens.text(currentToken), currentToken.line, currentToken.column);
         }
     }
-    std::cout << "Invalid input: Unexpected end of input." << std::endl;
-    exit(2);
+    throw std::runtime_error("Invalid input: Unexpected end of input.");
 }
 
 
@@ -117,17 +101,17 @@ std::string Parser::printInfix(Node* node) {
     if (node == nullptr) {
         return "";
     } else if (node->type == TokenType::IDENTIFIER) {
-        return node->value;
+        return std::string(node->value);
     } else if (node->type == TokenType::NUMBER) {
-        double numericValue = std::stod(node->value);
+        double numericValue = std::stod(std::string(node->value));
         std::string castedValue = customToString(numericValue);
         return castedValue;
     } else {
         std::string infix = "(";
-        for (size_t i = 0; i < node->children.size(); ++i) {
-            infix += printInfix(node->children[i]);
-            if (i < node->children.size() - 1) {
-                infix += " " + node->value + " ";
+        for (Node* child = node->firstChild; child; child = child->nextSibling) {
+            infix += printInfix(child);
+            if (child->nextSibling) {
+                infix += " " + std::string(node->value) + " ";
             }
         }
         infix += ")";
@@ -138,80 +122,72 @@ std::string Parser::printInfix(Node* node) {
 
 
 
-double Node::evaluate() {
+double Node::evaluate(std::unordered_map<std::string, double>& variables) {
     double result = 0.0;
 
     if (type == TokenType::OPERATOR) {
         if (value == "+") {
-            for (Node* child : children) {
-                result += child->evaluate();
+            for (Node* child = firstChild; child; child = child->nextSibling) {
+                result += child->evaluate(variables);
             }
         } else if (value == "-") {
-            if (children.size() == 0) {
-                std::cout << "Invalid number of children for operator: " + value << std::endl;
-                exit(2);
+            if (childCount == 0) {
+                throw std::runtime_error("Invalid number of children for operator: " + std::string(value));
             }
-            result = children[0]->evaluate();
-            for (size_t i = 1; i < children.size(); ++i) {
-                result -= children[i]->evaluate();
+            result = firstChild->evaluate(variables);
+            for (Node* child = firstChild->nextSibling; child; child = child->nextSibling) {
+                result -= child->evaluate(variables);
             }
         } else if (value == "*") {
             result = 1.0;
-            for (Node* child : children) {
-                result *= child->evaluate();
+            for (Node* child = firstChild; child; child = child->nextSibling) {
+                result *= child->evaluate(variables);
             }
         } else if (value == "/") {
-            if (children.size() == 0) {
-                std::cout << "Invalid number of children for operator: " + value << std::endl;
-                exit(3);
+            if (childCount == 0) {
+                throw std::runtime_error("Invalid number of children for operator: " + std::string(value));
             }
-            result = children[0]->evaluate();
-            for (size_t i = 1; i < children.size(); ++i) {
-                if (children[i]->evaluate() == 0.0) {
-                    std::cout << "Runtime error: division by zero." << std::endl;
-                    exit(3);
+            result = firstChild->evaluate(variables);
+            for (Node* child = firstChild->nextSibling; child; child = child->nextSibling) {
+                if (child->evaluate(variables) == 0.0) {
+                    throw DivisionByZeroException();
                 }
-                result /= children[i]->evaluate();
+                result /= child->evaluate(variables);
             }
         } else {
-            std::cout << "Invalid operator: " + value << std::endl;
-            exit(2);
+            throw std::runtime_error("Invalid operator: " + std::string(value));
         }
     } else if (type == TokenType::IDENTIFIER) {
-        result = variableMap[value];
+        result = variables[std::string(value)];
     } else if (type == TokenType::ASSIGNMENT) {
-        if (children.size() == 0) {
-            std::cout << "Invalid number of children for assignment: " + value << std::endl;
-            exit(2);
+        if (childCount == 0) {
+            throw std::runtime_error("Invalid number of children for assignment: " + std::string(value));
         } else {
             bool found_result = false;
-            for (size_t i = 0; i < children.size(); ++i) {
-                if (children[i]->type != TokenType::IDENTIFIER) {
+            for (Node* child = firstChild; child; child = child->nextSibling) {
+                if (child->type != TokenType::IDENTIFIER) {
                     found_result = true;
-                    result = children[i]->evaluate();
+                    result = child->evaluate(variables);
                 }
             }
             if (found_result) {
-                for (size_t i = 0; i < children.size(); ++i) {
-                    if (children[i]->type == TokenType::IDENTIFIER) {
-                        variableMap[children[i]->value] = result;
+                for (Node* child = firstChild; child; child = child->nextSibling) {
+                    if (child->type == TokenType::IDENTIFIER) {
+                        variables[std::string(child->value)] = result;
                     }
                 }
             } else {
-                std::cout << "Invalid value for assignment: " + value << std::endl;
-                exit(2);
+                throw std::runtime_error("Invalid value for assignment: " + std::string(value));
             }
         }
     } else if (type == TokenType::NUMBER) {
-        std::istringstream ss(value);
+        std::istringstream ss{std::string(value)};
         ss >> result;
         if (ss.fail()) {
-            std::cout << "Invalid input: " + value << std::endl;
-            exit(2);
+            throw std::runtime_error("Invalid input: " + std::string(value));
         }
     } else {
-        std::cout << "Invalid input: " + value << std::endl;
-        exit(2);
+        throw std::runtime_error("Invalid input: " + std::string(value));
     }
 
     return result;
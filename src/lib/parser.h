@@ -1,21 +1,31 @@
 #ifndef PARSER_H
 #define PARSER_H
 #include "token.h"
+#include "tokenStream.h"
+#include "arena.h"
+#include <string>
+#include <string_view>
 #include <vector>
+#include <memory>
 #include <unordered_map>
 
+// Nodes live in the parser's Arena, children included, and are freed by resetting it
 class Node {
 public:
-    static std::unordered_map<std::string, double> variableMap;  //store variable's value
-    std::string value;
+    std::string_view value;   // points into the arena
     TokenType type;
-    std::vector<Node*> children;   // Vector to store children nodes
+    // Children form a linked list so a node needs no allocation besides its own
+    Node* firstChild = nullptr;
+    Node* lastChild = nullptr;
+    Node* nextSibling = nullptr;
+    size_t childCount = 0;
 
 
-    Node(const std::string& val) : value(val), type(TokenType::OPERATOR) {}
-    Node(const std::string& val, const TokenType& tp) : value(val), type(tp) {}
-    ~Node();
-    double evaluate();
+    Node(std::string_view val) : value(val), type(TokenType::OPERATOR) {}
+    Node(std::string_view val, const TokenType& tp) : value(val), type(tp) {}
+    void addChild(Node* child);
+    // Reads and assigns variables in the caller's map, so separate parsers share no state
+    double evaluate(std::unordered_map<std::string, double>& variables);
 
     int getPrecedence() const {
         if (value == "*" || value == "/") {
@@ -30,19 +40,27 @@ public:
 
 class Parser {
 public:
-    Parser(const std::vector<Token>& tokens);
+    // Nodes are allocated in arena. The buffer is read in place, so it must outlive the parser.
+    Parser(const TokenBuffer& tokens, Arena& arena);
+    // Tokens are pulled from the stream only as the parser reaches them
+    Parser(TokenStream& tokens, Arena& arena);
     ~Parser();
 
+    // Invalid input throws UnexpectedTokenException, or std::runtime_error at the end of input
     std::vector<Node*> parse();
     Node* parseExpression();
-    double evaluate(Node* node);
     std::string printInfix(Node* node);
 
 private:
-    const std::vector<Token> tokens;
-    
-    size_t currentTokenIndex;
+    std::unique_ptr<TokenStream> ownedTokens;  // set when constructed from a buffer
+    TokenStream& tokens;
+    Arena& arena;
+    Token currentToken;
+    bool exhausted = false;  // true once the parser has moved past the END token
+
     std::vector<Node*> roots;
+
+    void nextToken();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "server.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "stats.h"
+
+namespace {
+
+// Bytes read from a connection at a time
+const size_t READ_SIZE = 1 << 16;
+// Events taken from epoll per wait
+const int MAX_EVENTS = 64;
+
+std::runtime_error systemError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+Server::Session::Session(int fd, Engine engine, size_t cacheSize)
+    : fd(fd), interpreter(engine, cacheSize) {}
+
+Server::Session::~Session() {
+    ::close(fd);
+}
+
+Server::Server(const std::string& path, Engine engine, size_t cacheSize)
+    : path(path), engine(engine), cacheSize(cacheSize) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Invalid socket path " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // A socket left by a server that did not exit cleanly; any other file is kept
+    struct stat existing;
+    if (stat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        unlink(path.c_str());
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        throw systemError("Cannot create socket");
+    }
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        std::runtime_error error = systemError("Cannot bind socket " + path);
+        ::close(listener);
+        throw error;
+    }
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    if (listen(listener, SOMAXCONN) < 0 || epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event) < 0) {
+        std::runtime_error error = systemError("Cannot listen on socket " + path);
+        if (epoll >= 0) {
+            ::close(epoll);
+        }
+        ::close(listener);
+        unlink(path.c_str());
+        throw error;
+    }
+}
+
+Server::~Server() {
+    sessions.clear();
+    ::close(epoll);
+    ::close(listener);
+    unlink(path.c_str());
+}
+
+void Server::run(const volatile std::sig_atomic_t& stop, const std::function<void()>& afterEvents) {
+    epoll_event events[MAX_EVENTS];
+    while (!stop) {
+        int count = epoll_wait(epoll, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno != EINTR) {
+                throw systemError("Cannot wait for connections");
+            }
+            afterEvents();
+            continue;
+        }
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listener) {
+                accept();
+                continue;
+            }
+            auto found = sessions.find(fd);
+            if (found == sessions.end()) {
+                continue;
+            }
+            Session& session = *found->second;
+            bool open = true;
+            try {
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    open = receive(session);
+                }
+                if (open && (events[i].events & EPOLLOUT)) {
+                    open = flush(session);
+                }
+            } catch (const std::exception&) {
+                // Failures of a statement become its reply, so this session is broken
+                open = false;
+            }
+            if (!open) {
+                close(fd);
+            }
+        }
+        afterEvents();
+    }
+}
+
+void Server::accept() {
+    while (true) {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            // EAGAIN once the backlog is empty; other errors only lose that connection
+            return;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(fd);
+            continue;
+        }
+        sessions[fd] = std::make_unique<Session>(fd, engine, cacheSize);
+    }
+}
+
+bool Server::receive(Session& session) {
+    if (session.inputClosed) {
+        return flush(session);
+    }
+    char buffer[READ_SIZE];
+    ssize_t received = read(session.fd, buffer, sizeof(buffer));
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    // Every complete line is answered, so a client may send many before reading replies
+    session.input.append(buffer, received);
+    size_t first = 0;
+    size_t newline;
+    while ((newline = session.input.find('\n', first)) != std::string::npos) {
+        handleLine(session, std::string_view(session.input).substr(first, newline - first));
+        first = newline + 1;
+    }
+    session.input.erase(0, first);
+
+    if (received == 0) {
+        // As with std::getline, a last line without '\n' is still a statement
+        session.inputClosed = true;
+        if (!session.input.empty()) {
+            handleLine(session, session.input);
+            session.input.clear();
+        }
+    }
+    return flush(session);
+}
+
+void Server::handleLine(Session& session, std::string_view line) {
+    ScopedPhaseTimer timer(Phase::REQUEST);
+    session.interpreter.execute(line, session.replies);
+    session.output += session.replies.str();
+    session.replies.str(std::string());
+    Stats::addLines(1);
+}
+
+bool Server::flush(Session& session) {
+    while (session.written < session.output.size()) {
+        ssize_t sent = send(session.fd, session.output.data() + session.written,
+                            session.output.size() - session.written, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        session.written += sent;
+    }
+    if (session.written == session.output.size()) {
+        session.output.clear();
+        session.written = 0;
+    }
+
+    // Wait for the socket to drain instead of reading more than the client takes back
+    bool pending = !session.output.empty();
+    if (pending == session.writable) {
+        epoll_event event{};
+        event.events = pending ? EPOLLOUT : EPOLLIN;
+        event.data.fd = session.fd;
+        if (epoll_ctl(epoll, EPOLL_CTL_MOD, session.fd, &event) < 0) {
+            return false;
+        }
+        session.writable = !pending;
+    }
+    // A client that finished sending is closed once its last reply is written
+    return !session.inputClosed || pending;
+}
+
+void Server::close(int fd) {
+    epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+    sessions.erase(fd);
+}
@@ -0,0 +1,60 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <csignal>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include "interpreter.h"
+
+// Long-running calc daemon on a Unix domain socket. Each connection is a session with its
+// own variables: every line it sends is evaluated as calc evaluates a line of standard
+// input, and the reply is exactly what calc would print for it. Clients may send many
+// lines without waiting for replies; one thread serves every connection from an epoll loop.
+class Server {
+public:
+    // Listens on path, replacing a stale socket left there. Throws std::runtime_error on failure.
+    // cacheSize is the --cache-size of each session; 0 parses every line.
+    Server(const std::string& path, Engine engine, size_t cacheSize);
+    ~Server();
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Serves connections until stop is set by a signal handler. afterEvents is called
+    // after each round of events and whenever a signal interrupts the wait.
+    void run(const volatile std::sig_atomic_t& stop, const std::function<void()>& afterEvents);
+
+private:
+    struct Session {
+        Session(int fd, Engine engine, size_t cacheSize);
+        ~Session();
+
+        int fd;
+        Interpreter interpreter;
+        std::string input;            // received bytes after the last complete line
+        std::ostringstream replies;   // what execute() printed for the lines just handled
+        std::string output;           // replies not yet written to the socket
+        size_t written = 0;           // bytes of output already written
+        bool inputClosed = false;     // the client has finished sending
+        bool writable = true;         // false while waiting for EPOLLOUT
+    };
+
+    std::string path;
+    Engine engine;
+    size_t cacheSize;
+    int listener = -1;
+    int epoll = -1;
+    std::unordered_map<int, std::unique_ptr<Session>> sessions;
+
+    void accept();
+    // Reads what the client sent and replies to its complete lines; false once the session is over
+    bool receive(Session& session);
+    void handleLine(Session& session, std::string_view line);
+    // Writes pending replies; false if the connection failed or the session is over
+    bool flush(Session& session);
+    void close(int fd);
+};
+
+#endif
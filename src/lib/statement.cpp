@@ -0,0 +1,160 @@
+#include "statement.h"
+#include "bufferLexer.h"
+#include "token.h"
+#include "constantFolding.h"
+#include "stats.h"
+
+void parseStatement(std::string_view line, SymbolTable& symbolTable, Arena& arena, ParsedStatement& statement) {
+    // Lexes the line in place; tokens refer to it instead of copying their text
+    BufferLexer lexer(line);
+    const TokenBuffer* tokens;
+    try {
+        ScopedPhaseTimer timer(Phase::LEX);
+        tokens = &lexer.tokenize();
+    } catch (const SyntaxError& e) {
+        Stats::countException(e);
+        // Nothing was parsed, so only the message is left
+        statement.root = nullptr;
+        statement.optimized = nullptr;
+        statement.program = nullptr;
+        statement.text = e.what();
+        statement.failure = nullptr;
+        return;
+    }
+    Stats::addTokens(tokens->tokens.size());
+    parseStatement(*tokens, 0, tokens->tokens.size() - 1, symbolTable, arena, statement);
+}
+
+void parseStatement(const TokenBuffer& tokens, size_t first, size_t last, SymbolTable& symbolTable, Arena& arena,
+                    ParsedStatement& statement) {
+    // statement may be reused from an earlier line; text keeps its capacity
+    statement.root = nullptr;
+    statement.optimized = nullptr;
+    statement.program = nullptr;
+    statement.text.clear();
+    statement.failure = nullptr;
+
+    // Errors at the end of the statement are reported where END would be on its own line
+    const Token& end = tokens.tokens[last];
+    size_t nodesBefore = arena.objectsAllocated();
+    try {
+        if (last > first && tokens.tokens[last - 1].kind == TokenKind::ERROR) {
+            const Token& error = tokens.tokens[last - 1];
+            throw SyntaxError(error.line, error.column);
+        }
+
+        {
+            ScopedPhaseTimer timer(Phase::PARSE);
+            int openParenthesesCount = 0;  // Track open parentheses
+            for (size_t i = first; i < last; ++i) {
+                if (tokens.tokens[i].kind == TokenKind::LEFT_PAREN) {
+                    openParenthesesCount++;
+                } else if (tokens.tokens[i].kind == TokenKind::RIGHT_PAREN) {
+                    openParenthesesCount--;
+                    if (openParenthesesCount < 0) {
+                        throw UnexpectedTokenException(")", end.line, end.column - 1);
+                    }
+                }
+            }
+
+            if (openParenthesesCount > 0) {
+                throw UnexpectedTokenException("END", end.line, end.column);
+            }
+
+            BufferTokenStream stream(tokens, first, last);
+            infixParser parser(stream, symbolTable, arena);
+            statement.root = parser.infixparse();
+        }
+
+        if (statement.root) {
+            // Render the AST in infix notation
+            {
+                ScopedPhaseTimer timer(Phase::PRINT);
+                appendInfix(statement.root, statement.text);
+            }
+            ScopedPhaseTimer timer(Phase::FOLD);
+            statement.optimized = foldConstants(statement.root, arena);
+        } else {
+            statement.text = "Failed to parse the input expression.";
+        }
+    } catch (const UnexpectedTokenException& e) {
+        Stats::countException(e);
+        statement.text = e.what();
+    } catch (const SyntaxError& e) {
+        Stats::countException(e);
+        statement.text = e.what();
+    }
+    Stats::addNodes(arena.objectsAllocated() - nodesBefore);
+}
+
+void StatementExecutor::execute(const ParsedStatement& statement, std::ostream& out) {
+    if (statement.failure) {
+        std::rethrow_exception(statement.failure);
+    }
+    {
+        ScopedPhaseTimer timer(Phase::OUTPUT);
+        out << statement.text << '\n';
+    }
+    if (!statement.root) {
+        return;
+    }
+
+    const Assignment* definition = asLiveDefinition(statement.optimized);
+    try {
+        // Journal this line's writes so a failure can be undone
+        {
+            ScopedPhaseTimer timer(Phase::TRANSACTION);
+            symbolTable.begin();
+        }
+        double result;
+        try {
+            ScopedPhaseTimer timer(Phase::EVALUATE);
+            if (definition) {
+                if (!liveDefinitions) {
+                    throw InvalidDefinitionException("live definitions are not available here");
+                }
+                liveDefinitions->check(definition);
+            }
+            result = evaluate(statement);
+            if (liveDefinitions) {
+                liveDefinitions->propagate();
+            }
+        } catch (const std::runtime_error&) {
+            ScopedPhaseTimer timer(Phase::TRANSACTION);
+            symbolTable.rollback();
+            throw;
+        }
+        {
+            ScopedPhaseTimer timer(Phase::TRANSACTION);
+            if (liveDefinitions) {
+                liveDefinitions->update(definition);
+            }
+            symbolTable.commit();
+        }
+        // The static type decides whether the result prints as a boolean
+        ScopedPhaseTimer timer(Phase::OUTPUT);
+        out << Value::fromResult(statement.root->type, result) << '\n';
+    } catch (const std::runtime_error& e) {
+        Stats::countException(e);
+        ScopedPhaseTimer timer(Phase::OUTPUT);
+        out << e.what() << '\n';
+    }
+}
+
+double StatementExecutor::evaluate(const ParsedStatement& statement) {
+    if (engine == Engine::VM && statement.program) {
+        return vm.run(*statement.program, symbolTable);
+    }
+    return evaluate(statement.optimized);
+}
+
+double StatementExecutor::evaluate(const ASTNode* root) {
+    if (engine == Engine::VM) {
+        return vm.run(compiler.compile(root), symbolTable);
+    }
+    double result;
+    if (engine == Engine::JIT && jit.run(root, symbolTable, result)) {
+        return result;
+    }
+    return treeEvaluator.evaluate(root);
+}
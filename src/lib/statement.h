@@ -0,0 +1,69 @@
+#ifndef STATEMENT_H
+#define STATEMENT_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <exception>
+#include <iostream>
+#include "arena.h"
+#include "infixParser.h"
+#include "symbolTable.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "cseEvaluator.h"
+#include "jit.h"
+#include "liveDefinitions.h"
+
+// Evaluation engines selectable with --engine
+enum class Engine {
+    TREE,  // walk the AST with CseEvaluator
+    VM,    // compile the AST to bytecode and run it on the VirtualMachine
+    JIT    // compile statements that run often to native code, interpreting the rest
+};
+
+// Front-end result for one input line: the parsed tree and its infix rendering,
+// or the message of the lexer or parser error that stopped it
+struct ParsedStatement {
+    ASTNode* root = nullptr;      // allocated in the arena given to parseStatement()
+    ASTNode* optimized = nullptr; // root after foldConstants(); this is what gets evaluated
+    const Program* program = nullptr;  // bytecode for optimized when compiled ahead of time (StatementCache)
+    std::string text;             // infix rendering of root, or the error message when root is null
+    std::exception_ptr failure;   // unexpected exception, rethrown when the statement is executed
+};
+
+// Lex and parse one line, allocating its tree in arena. The symbol table is only used to
+// intern identifiers, so lines can be parsed ahead of (and concurrently with) the
+// statements before them. statement is overwritten, so one can be reused for every line.
+void parseStatement(std::string_view line, SymbolTable& symbolTable, Arena& arena, ParsedStatement& statement);
+
+// Parses the statement in tokens [first, last) of a buffer filled by BufferLexer::tokenizeLines(),
+// where tokens[last] is the NEWLINE or END token that ends it
+void parseStatement(const TokenBuffer& tokens, size_t first, size_t last, SymbolTable& symbolTable, Arena& arena,
+                    ParsedStatement& statement);
+
+// Evaluates parsed statements in order and prints what calc prints for each line
+class StatementExecutor {
+public:
+    // Without liveDefinitions, ":=" statements fail with an error
+    StatementExecutor(SymbolTable& symbolTable, Engine engine, LiveDefinitions* liveDefinitions = nullptr)
+        : symbolTable(symbolTable), engine(engine), liveDefinitions(liveDefinitions), treeEvaluator(symbolTable) {}
+
+    void execute(const ParsedStatement& statement, std::ostream& out);
+
+    // Runs root on the selected engine without a transaction; the caller undoes writes on failure
+    double evaluate(const ASTNode* root);
+
+private:
+    SymbolTable& symbolTable;
+    Engine engine;
+    LiveDefinitions* liveDefinitions;
+    CseEvaluator treeEvaluator;
+    BytecodeCompiler compiler;
+    VirtualMachine vm;
+    Jit jit;
+
+    double evaluate(const ParsedStatement& statement);
+};
+
+#endif
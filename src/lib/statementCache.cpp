@@ -0,0 +1,74 @@
+#include "statementCache.h"
+#include <cctype>
+
+// Collapses runs of whitespace to one space and drops leading and trailing whitespace,
+// which the Lexer skips anyway
+static void normalize(std::string_view line, std::string& key) {
+    key.clear();
+    bool pendingSpace = false;
+    for (char c : line) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !key.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            key.push_back(' ');
+            pendingSpace = false;
+        }
+        key.push_back(c);
+    }
+}
+
+const ParsedStatement& StatementCache::parse(std::string_view line) {
+    normalize(line, key);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        hitCount++;
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->statement;
+    }
+    missCount++;
+
+    // Reuse the least recently used entry once the cache is full
+    if (entries.size() < capacity || entries.empty()) {
+        entries.emplace_front();
+    } else {
+        if (!entries.back().key.empty()) {
+            index.erase(entries.back().key);
+        }
+        entries.splice(entries.begin(), entries, std::prev(entries.end()));
+    }
+    Entry& entry = entries.front();
+    entry.key.clear();
+    entry.arena.reset();
+    parseStatement(line, symbolTable, entry.arena, entry.statement);
+
+    if (!entry.statement.root || entry.statement.failure || capacity == 0) {
+        // Not kept: make it the first entry to be reused
+        entries.splice(entries.end(), entries, entries.begin());
+        return entries.back().statement;
+    }
+    entry.key = key;
+    index.emplace(entry.key, entries.begin());
+    if (engine == Engine::VM) {
+        entry.program = compiler.compile(entry.statement.optimized);
+        entry.statement.program = &entry.program;
+    }
+    return entry.statement;
+}
+
+size_t StatementCache::objectsAllocated() const {
+    size_t total = 0;
+    for (const Entry& entry : entries) {
+        total += entry.arena.objectsAllocated();
+    }
+    return total;
+}
+
+size_t StatementCache::blocksAllocated() const {
+    size_t total = 0;
+    for (const Entry& entry : entries) {
+        total += entry.arena.blocksAllocated();
+    }
+    return total;
+}
@@ -0,0 +1,54 @@
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "arena.h"
+#include "bytecode.h"
+#include "statement.h"
+#include "symbolTable.h"
+
+// Bounded LRU cache from statement text to its parsed form, its infix rendering and, for
+// the VM engine, its bytecode. Lines are keyed with runs of whitespace collapsed, so a
+// hit skips the Lexer and infixParser entirely. Only statements that parsed cleanly are
+// kept: error messages carry column numbers, which depend on the exact spacing.
+class StatementCache {
+public:
+    StatementCache(size_t capacity, SymbolTable& symbolTable, Engine engine)
+        : capacity(capacity), symbolTable(symbolTable), engine(engine) {}
+
+    // The parsed form of line, valid until the next call
+    const ParsedStatement& parse(std::string_view line);
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+
+    // Allocation totals of the entries' arenas
+    size_t objectsAllocated() const;
+    size_t blocksAllocated() const;
+
+private:
+    // Each entry keeps its tree in its own arena; evicted entries are reused, arena included
+    struct Entry {
+        std::string key;
+        Arena arena{2 * 1024};
+        ParsedStatement statement;
+        Program program;
+    };
+
+    size_t capacity;
+    SymbolTable& symbolTable;
+    Engine engine;
+    BytecodeCompiler compiler;
+
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;  // keys view Entry::key
+    std::string key;  // reused buffer for the normalized line
+
+    size_t hitCount = 0;
+    size_t missCount = 0;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "stats.h"
+#include "infixParser.h"
+#include "lexer.h"
+#include "liveDefinitions.h"
+
+std::atomic<uint64_t> Stats::lines{0};
+std::atomic<uint64_t> Stats::tokens{0};
+std::atomic<uint64_t> Stats::nodes{0};
+
+namespace {
+
+// Bucket b of a histogram counts latencies below 2^b ns, and at least 2^(b-1) for b > 0
+const size_t BUCKETS = 48;
+const size_t PHASES = static_cast<size_t>(Phase::COUNT);
+
+const char* const PHASE_NAMES[PHASES] = {
+    "lex", "parse", "print", "fold", "evaluate", "transaction", "output", "request"
+};
+
+struct PhaseCounters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> nanoseconds{0};
+    std::atomic<uint64_t> histogram[BUCKETS] = {};
+};
+
+PhaseCounters phases[PHASES];
+
+enum ExceptionKind {
+    SYNTAX_ERROR,
+    UNEXPECTED_TOKEN,
+    UNKNOWN_IDENTIFIER,
+    DIVISION_BY_ZERO,
+    INVALID_OPERAND_TYPE,
+    INVALID_OPERATOR,
+    INVALID_DEFINITION,
+    OTHER_EXCEPTION,
+    EXCEPTION_KINDS
+};
+
+const char* const EXCEPTION_NAMES[EXCEPTION_KINDS] = {
+    "SyntaxError", "UnexpectedTokenException", "UnknownIdentifierException", "DivisionByZeroException",
+    "InvalidOperandTypeException", "InvalidOperatorException", "InvalidDefinitionException", "other"
+};
+
+std::atomic<uint64_t> exceptions[EXCEPTION_KINDS] = {};
+
+ExceptionKind kindOf(const std::exception& error) {
+    if (dynamic_cast<const SyntaxError*>(&error)) return SYNTAX_ERROR;
+    if (dynamic_cast<const UnexpectedTokenException*>(&error)) return UNEXPECTED_TOKEN;
+    if (dynamic_cast<const UnknownIdentifierException*>(&error)) return UNKNOWN_IDENTIFIER;
+    if (dynamic_cast<const DivisionByZeroException*>(&error)) return DIVISION_BY_ZERO;
+    if (dynamic_cast<const InvalidOperandTypeException*>(&error)) return INVALID_OPERAND_TYPE;
+    if (dynamic_cast<const InvalidOperatorException*>(&error)) return INVALID_OPERATOR;
+    if (dynamic_cast<const InvalidDefinitionException*>(&error)) return INVALID_DEFINITION;
+    return OTHER_EXCEPTION;
+}
+
+size_t bucketOf(uint64_t nanoseconds) {
+    size_t bucket = 0;
+    while (nanoseconds > 0 && bucket < BUCKETS - 1) {
+        nanoseconds >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// Upper bound of the bucket holding the given percentile of the calls
+uint64_t percentile(const PhaseCounters& counters, uint64_t calls, unsigned percent) {
+    uint64_t rank = (calls * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += counters.histogram[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return uint64_t(1) << bucket;
+        }
+    }
+    return uint64_t(1) << (BUCKETS - 1);
+}
+
+}  // namespace
+
+void Stats::recordPhase(Phase phase, uint64_t nanoseconds) {
+    PhaseCounters& counters = phases[static_cast<size_t>(phase)];
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    counters.histogram[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::countException(const std::exception& error) {
+    if (on) {
+        exceptions[kindOf(error)].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Stats::print(std::ostream& out) {
+    out << "Lines processed: " << lines.load(std::memory_order_relaxed) << '\n'
+        << "Tokens lexed: " << tokens.load(std::memory_order_relaxed) << '\n'
+        << "AST nodes allocated: " << nodes.load(std::memory_order_relaxed) << '\n';
+    for (size_t phase = 0; phase < PHASES; ++phase) {
+        const PhaseCounters& counters = phases[phase];
+        uint64_t calls = counters.calls.load(std::memory_order_relaxed);
+        out << "Phase " << PHASE_NAMES[phase] << ": " << calls << " calls, "
+            << counters.nanoseconds.load(std::memory_order_relaxed) / 1000 << " us total";
+        if (calls > 0) {
+            out << ", p50 < " << percentile(counters, calls, 50) << " ns"
+                << ", p90 < " << percentile(counters, calls, 90) << " ns"
+                << ", p99 < " << percentile(counters, calls, 99) << " ns";
+        }
+        out << '\n';
+    }
+    for (size_t kind = 0; kind < EXCEPTION_KINDS; ++kind) {
+        out << "Exceptions " << EXCEPTION_NAMES[kind] << ": " << exceptions[kind].load(std::memory_order_relaxed)
+            << '\n';
+    }
+    out.flush();
+}
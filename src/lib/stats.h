@@ -0,0 +1,78 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <ostream>
+
+// Work done for each line, timed separately by --stats
+enum class Phase {
+    LEX,          // Lexer::tokenize()
+    PARSE,        // parenthesis check and infixParser::infixparse()
+    PRINT,        // appendInfix() of the parsed tree
+    FOLD,         // foldConstants()
+    EVALUATE,     // the engine, plus checking and recomputing live definitions
+    TRANSACTION,  // SymbolTable begin(), commit() and rollback()
+    OUTPUT,       // writing the echoed text and the result
+    REQUEST,      // --serve: a whole statement, from reading its line to queueing the reply
+    COUNT
+};
+
+// Process-wide counters and per-phase latency histograms for --stats. They are relaxed
+// atomics so batch mode's threads can record into them. Until enable() is called nothing
+// is recorded and the clock is never read, so the only cost is a branch per phase.
+class Stats {
+public:
+    // Call before any worker thread starts; enabled() is a plain read afterwards
+    static void enable() { on = true; }
+    static bool enabled() { return on; }
+
+    static void addLines(uint64_t count) { add(lines, count); }
+    static void addTokens(uint64_t count) { add(tokens, count); }
+    static void addNodes(uint64_t count) { add(nodes, count); }
+    static void recordPhase(Phase phase, uint64_t nanoseconds);
+    // Counts an exception that reached the user as an error message
+    static void countException(const std::exception& error);
+
+    // Writes every counter and, per phase, call count, total time and latency percentiles
+    static void print(std::ostream& out);
+
+private:
+    static inline bool on = false;
+    static std::atomic<uint64_t> lines;
+    static std::atomic<uint64_t> tokens;
+    static std::atomic<uint64_t> nodes;
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t count) {
+        if (on) {
+            counter.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Times one phase from construction to destruction when stats are enabled
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(Phase phase) : phase(phase) {
+        if (Stats::enabled()) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~ScopedPhaseTimer() {
+        if (Stats::enabled()) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            Stats::recordPhase(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+    }
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
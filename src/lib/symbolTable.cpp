@@ -0,0 +1,46 @@
+#include "symbolTable.h"
+
+int SymbolTable::intern(const std::string& name) {
+    std::string_view storedName;
+    return intern(name, storedName);
+}
+
+int SymbolTable::intern(const std::string& name, std::string_view& storedName) {
+    std::lock_guard<std::mutex> lock(internMutex);
+    auto found = ids.find(name);
+    if (found != ids.end()) {
+        storedName = names[found->second];
+        return found->second;
+    }
+    int id = static_cast<int>(slots.size());
+    ids.emplace(name, id);
+    names.push_back(name);
+    slots.emplace_back();
+    storedName = names.back();
+    return id;
+}
+
+void SymbolTable::begin() {
+    journal.clear();
+    inTransaction = true;
+}
+
+void SymbolTable::commit() {
+    journal.clear();
+    inTransaction = false;
+}
+
+void SymbolTable::rollback() {
+    // Undo newest first so a slot written twice ends up with its value from before begin()
+    for (auto entry = journal.rbegin(); entry != journal.rend(); ++entry) {
+        slots[entry->id] = entry->previous;
+    }
+    journal.clear();
+    inTransaction = false;
+}
+
+void SymbolTable::collectWrites(std::vector<int>& ids) const {
+    for (const JournalEntry& entry : journal) {
+        ids.push_back(entry.id);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+
+// Variables of a session. Identifiers are interned once by the parser into integer
+// symbol ids, and each id indexes a slot in a dense value array.
+// Writes made between begin() and commit() are journaled so rollback() can undo them;
+// both cost as much as the number of writes, not the number of variables.
+class SymbolTable {
+public:
+    struct Slot {
+        double value = 0.0;
+        bool defined = false;
+    };
+
+    // Returns the id of name, giving it a new undefined slot the first time it is seen.
+    // Safe to call from several parsing threads, but not while statements are being evaluated.
+    int intern(const std::string& name);
+    // As intern(), also returning a view of the stored copy of name that lives as long as the table
+    int intern(const std::string& name, std::string_view& storedName);
+
+    const std::string& name(int id) const { return names[id]; }
+    bool isDefined(int id) const { return slots[id].defined; }
+    double get(int id) const { return slots[id].value; }
+    void set(int id, double value) {
+        if (inTransaction) {
+            journal.push_back({id, slots[id]});
+        }
+        slots[id].value = value;
+        slots[id].defined = true;
+    }
+    size_t size() const { return slots.size(); }
+
+    // Direct access to a slot, for callers that undo their own writes outside a transaction
+    Slot slot(int id) const { return slots[id]; }
+    void restore(int id, const Slot& previous) { slots[id] = previous; }
+    // The dense slot array itself, indexed by id, for compiled code that reads variables directly
+    const Slot* slotData() const { return slots.data(); }
+
+    // Transaction around a statement, so a failure part way leaves no writes behind
+    void begin();
+    void commit();
+    void rollback();
+    // Appends the ids written since begin(), in write order and possibly repeated
+    void collectWrites(std::vector<int>& ids) const;
+
+private:
+    std::mutex internMutex;
+
+    struct JournalEntry {
+        int id;
+        Slot previous;
+    };
+
+    bool inTransaction = false;
+    std::vector<JournalEntry> journal;
+
+    std::unordered_map<std::string, int> ids;
+    std::deque<std::string> names;  // deque keeps references returned by name() stable
+    std::vector<Slot> slots;
+};
+
+#endif
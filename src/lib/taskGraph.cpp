@@ -0,0 +1,90 @@
+#include "taskGraph.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+void TaskGraph::addDependency(size_t before, size_t after) {
+    std::vector<size_t>& edges = dependents[before];
+    // Edges are usually added in order, so this catches most duplicates
+    if (!edges.empty() && edges.back() == after) {
+        return;
+    }
+    edges.push_back(after);
+    dependencyCount[after]++;
+}
+
+namespace {
+
+// Ready tasks of one thread. The owner works from the back, thieves take from the front.
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+
+    void push(size_t task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(task);
+    }
+
+    bool popBack(size_t& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) {
+            return false;
+        }
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+
+    bool stealFront(size_t& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) {
+            return false;
+        }
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+};
+
+}
+
+void TaskGraph::execute(ThreadPool& pool, const std::function<void(size_t, size_t)>& run) const {
+    size_t taskCount = dependents.size();
+    size_t threadCount = pool.size();
+
+    std::unique_ptr<std::atomic<int>[]> pending(new std::atomic<int>[taskCount]);
+    std::unique_ptr<WorkQueue[]> queues(new WorkQueue[threadCount]);
+    size_t nextQueue = 0;
+    for (size_t task = 0; task < taskCount; ++task) {
+        pending[task] = dependencyCount[task];
+        if (dependencyCount[task] == 0) {
+            queues[nextQueue].tasks.push_back(task);
+            nextQueue = (nextQueue + 1) % threadCount;
+        }
+    }
+
+    std::atomic<size_t> finished{0};
+    pool.runOnEachThread([&](size_t self, size_t) {
+        while (finished.load() < taskCount) {
+            size_t task;
+            bool found = queues[self].popBack(task);
+            for (size_t offset = 1; !found && offset < threadCount; ++offset) {
+                found = queues[(self + offset) % threadCount].stealFront(task);
+            }
+            if (!found) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            run(task, self);
+            for (size_t dependent : dependents[task]) {
+                if (pending[dependent].fetch_sub(1) == 1) {
+                    queues[self].push(dependent);
+                }
+            }
+            finished.fetch_add(1);
+        }
+    });
+}
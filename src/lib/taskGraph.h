@@ -0,0 +1,25 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <vector>
+#include <functional>
+#include "threadPool.h"
+
+// Tasks numbered 0..n-1 with "must finish before" edges between them
+class TaskGraph {
+public:
+    TaskGraph(size_t taskCount) : dependents(taskCount), dependencyCount(taskCount, 0) {}
+
+    void addDependency(size_t before, size_t after);
+
+    // Calls run(task, thread) for every task once all of its dependencies have finished.
+    // Each thread works through its own deque of ready tasks and steals from the other
+    // threads' deques when it runs dry. run must not throw.
+    void execute(ThreadPool& pool, const std::function<void(size_t, size_t)>& run) const;
+
+private:
+    std::vector<std::vector<size_t>> dependents;
+    std::vector<int> dependencyCount;
+};
+
+#endif
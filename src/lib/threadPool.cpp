@@ -0,0 +1,97 @@
+#include "threadPool.h"
+#include <algorithm>
+
+// Indices handed out per grab, so threads do not contend on nextIndex for every item
+static const size_t GRAIN = 64;
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const Body& body) {
+    if (workers.empty() || count <= GRAIN) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i, 0);
+        }
+        return;
+    }
+    startJob(body, count);
+}
+
+void ThreadPool::runOnEachThread(const Body& body) {
+    if (workers.empty()) {
+        body(0, 0);
+        return;
+    }
+    startJob(body, 0);
+}
+
+void ThreadPool::startJob(const Body& body, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &body;
+        jobCount = count;
+        nextIndex = 0;
+        busyWorkers = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runJob(body, count, 0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    size_t seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+        if (stopping) {
+            return;
+        }
+        seenGeneration = generation;
+        const Body* body = job;
+        size_t count = jobCount;
+
+        lock.unlock();
+        runJob(*body, count, self);
+        lock.lock();
+
+        if (--busyWorkers == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runJob(const Body& body, size_t count, size_t self) {
+    if (count == 0) {
+        body(self, self);
+        return;
+    }
+    while (true) {
+        size_t first = nextIndex.fetch_add(GRAIN);
+        if (first >= count) {
+            return;
+        }
+        size_t last = std::min(first + GRAIN, count);
+        for (size_t i = first; i < last; ++i) {
+            body(i, self);
+        }
+    }
+}
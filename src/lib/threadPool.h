@@ -0,0 +1,52 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Fixed set of worker threads that split loops between them. The calling thread takes
+// part in every loop as thread 0, so a pool of size 1 runs everything inline.
+class ThreadPool {
+public:
+    // Loop body, called with the item index and the index of the thread running it
+    using Body = std::function<void(size_t index, size_t thread)>;
+
+    ThreadPool(size_t threadCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Calls body(i, thread) for every i in [0, count) and returns once all calls have finished.
+    // body must not throw.
+    void parallelFor(size_t count, const Body& body);
+
+    // Calls body(thread, thread) exactly once on every thread of the pool, concurrently.
+    // body must not throw.
+    void runOnEachThread(const Body& body);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // Current job, published under mutex and identified by generation
+    const Body* job = nullptr;
+    size_t jobCount = 0;      // 0 means one call per thread
+    size_t generation = 0;
+    size_t busyWorkers = 0;
+    bool stopping = false;
+    std::atomic<size_t> nextIndex{0};
+
+    void workerLoop(size_t self);
+    void startJob(const Body& body, size_t count);
+    void runJob(const Body& body, size_t count, size_t self);
+};
+
+#endif
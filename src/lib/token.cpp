@@ -0,0 +1,54 @@
+#include "token.h"
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <string>
+
+std::string_view TokenBuffer::text(const Token& token) const {
+    if (token.kind == TokenKind::NUMBER) {
+        // The lexer only accepts digits with at most one '.', so the spelling ends at the first other character
+        size_t start = lineStarts[token.line - 1] + token.column - 1;
+        size_t end = start;
+        while (end < source.size() && (std::isdigit(static_cast<unsigned char>(source[end])) || source[end] == '.')) {
+            end++;
+        }
+        return source.substr(start, end - start);
+    }
+    if (token.kind == TokenKind::IDENTIFIER) {
+        return source.substr(token.span.offset, token.span.length);
+    }
+    return spellingOf(token.kind);
+}
+
+double TokenBuffer::parseNumber(std::string_view spelling) {
+    // Up to 15 digits are exact in a double, as is 10^k for k <= 22, so one correctly
+    // rounded division gives the same value as a full conversion
+    static const double POWERS_OF_TEN[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    if (spelling.size() <= 16) {
+        uint64_t digits = 0;
+        size_t fractionDigits = 0;
+        bool seenDot = false;
+        for (char c : spelling) {
+            if (c == '.') {
+                seenDot = true;
+            } else {
+                digits = digits * 10 + static_cast<uint64_t>(c - '0');
+                fractionDigits += seenDot;
+            }
+        }
+        if (spelling.size() - seenDot <= 15) {
+            return static_cast<double>(digits) / POWERS_OF_TEN[fractionDigits];
+        }
+    }
+
+    double value = 0;
+    std::from_chars_result result = std::from_chars(spelling.data(), spelling.data() + spelling.size(), value);
+    if (result.ec != std::errc()) {
+        // Out of range: strtod still gives the nearest value
+        value = std::strtod(std::string(spelling).c_str(), nullptr);
+    }
+    return value;
+}
@@ -1,8 +1,12 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
+// Category of a token, as the S-expression Parser's nodes record it
 enum class TokenType {
     LEFT_PAREN,
     RIGHT_PAREN,
@@ -13,17 +17,117 @@ enum class TokenType {
     BOOLEAN
 };
 
+// Exactly what a token is, so consumers switch on it instead of comparing text
+enum class TokenKind : uint8_t {
+    END,            // end of input; its text is "END"
+    LEFT_PAREN,
+    RIGHT_PAREN,
+    PLUS,
+    MINUS,
+    STAR,
+    SLASH,
+    PERCENT,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    EQUAL_EQUAL,
+    NOT_EQUAL,
+    AMPERSAND,
+    PIPE,
+    CARET,
+    LEFT_BRACE,
+    RIGHT_BRACE,
+    ASSIGN,         // "="
+    LIVE_ASSIGN,    // ":="
+    NUMBER,
+    IDENTIFIER,
+    TRUE,
+    FALSE,
+    NEWLINE,        // ends a line when BufferLexer::tokenizeLines() separates them
+    ERROR,          // where a SyntaxError stopped tokenizeLines() on this line
+    COUNT
+};
+
+// Text of every kind except NUMBER and IDENTIFIER, which have no fixed spelling
+constexpr std::string_view TOKEN_SPELLINGS[static_cast<size_t>(TokenKind::COUNT)] = {
+    "END", "(", ")", "+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=",
+    "&", "|", "^", "{", "}", "=", ":=", "", "", "true", "false", "\n", ""
+};
+
+constexpr std::string_view spellingOf(TokenKind kind) {
+    return TOKEN_SPELLINGS[static_cast<size_t>(kind)];
+}
+
+constexpr TokenType typeOf(TokenKind kind) {
+    switch (kind) {
+    case TokenKind::LEFT_PAREN: return TokenType::LEFT_PAREN;
+    case TokenKind::RIGHT_PAREN: return TokenType::RIGHT_PAREN;
+    case TokenKind::ASSIGN:
+    case TokenKind::LIVE_ASSIGN: return TokenType::ASSIGNMENT;
+    case TokenKind::NUMBER: return TokenType::NUMBER;
+    case TokenKind::IDENTIFIER: return TokenType::IDENTIFIER;
+    case TokenKind::TRUE:
+    case TokenKind::FALSE: return TokenType::BOOLEAN;
+    default: return TokenType::OPERATOR;
+    }
+}
+
+// Where a token's text is in the source
+struct Span {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// 16 bytes and trivially copyable, so tokens are stored and passed by value without
+// allocating. A NUMBER token holds its value, parsed by the lexer, in place of its span;
+// TokenBuffer::text() finds its spelling again from its line and column.
 struct Token {
-    int line;
-    int column;      
-    std::string text;
-    TokenType type;
+    union {
+        Span span;      // every kind but NUMBER
+        double number;  // NUMBER
+    };
+    uint32_t line;
+    uint32_t column : 24;
+    TokenKind kind : 8;
+
+    TokenType type() const { return typeOf(kind); }
+
+    static Token spanning(TokenKind kind, int line, int column, size_t offset, size_t length) {
+        Token token;
+        token.span = Span{static_cast<uint32_t>(offset), static_cast<uint32_t>(length)};
+        token.setPosition(kind, line, column);
+        return token;
+    }
+    static Token numeric(double value, int line, int column) {
+        Token token;
+        token.number = value;
+        token.setPosition(TokenKind::NUMBER, line, column);
+        return token;
+    }
+
+private:
+    void setPosition(TokenKind kind, int line, int column) {
+        this->line = static_cast<uint32_t>(line);
+        this->column = static_cast<uint32_t>(column);
+        this->kind = kind;
+    }
+};
 
-    Token(int line, int column, const std::string& text, TokenType type)
-        : line(line), column(column), text(text), type(type) {}
+static_assert(sizeof(Token) == 16, "Token is meant to be 16 bytes");
+static_assert(std::is_trivially_copyable<Token>::value, "Token is copied as plain bytes");
 
-    Token() : line(0), column(0), text(""), type(TokenType::OPERATOR) {}
+// The tokens of one source, contiguous and in order, ending with END. Spans point into
+// source, which must outlive the buffer.
+struct TokenBuffer {
+    std::string_view source;
+    std::vector<uint32_t> lineStarts{0};  // offset of the first character of each line
+    std::vector<Token> tokens;
 
+    std::string_view text(const Token& token) const;
+    // Parses the spelling of a NUMBER token as std::stod does, without its exceptions:
+    // a value out of range becomes infinity or the nearest denormal
+    static double parseNumber(std::string_view spelling);
 };
 
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,27 @@
+#include "tokenStream.h"
+
+// Returned once a stream is exhausted
+static const Token END_TOKEN = Token::spanning(TokenKind::END, 0, 0, 0, 0);
+
+Token LexerTokenStream::next() {
+    if (finished) {
+        return END_TOKEN;
+    }
+    Token token = lexer.nextToken();
+    if (token.kind == TokenKind::END) {
+        finished = true;
+    }
+    return token;
+}
+
+Token BufferTokenStream::next() {
+    if (index < last) {
+        return tokens.tokens[index++];
+    }
+    if (index == last) {
+        index++;
+        const Token& end = tokens.tokens[last];
+        return Token::spanning(TokenKind::END, end.line, end.column, end.span.offset, 0);
+    }
+    return END_TOKEN;
+}
@@ -0,0 +1,48 @@
+#ifndef TOKENSTREAM_H
+#define TOKENSTREAM_H
+
+#include <string_view>
+#include "token.h"
+#include "lexer.h"
+
+// Source of tokens that the parsers pull one at a time, so a whole expression never has
+// to be materialized as a token buffer before parsing starts.
+// Once the END token has been returned, next() keeps returning END at line 0 column 0.
+class TokenStream {
+public:
+    virtual ~TokenStream() {}
+    virtual Token next() = 0;
+    // Text of a token this stream returned
+    virtual std::string_view text(const Token& token) const = 0;
+};
+
+// Pulls tokens straight from a Lexer as they are needed
+class LexerTokenStream : public TokenStream {
+public:
+    LexerTokenStream(Lexer& lexer) : lexer(lexer) {}
+    Token next() override;
+    std::string_view text(const Token& token) const override { return lexer.text(token); }
+
+private:
+    Lexer& lexer;
+    bool finished = false;
+};
+
+// Replays tokens that were already collected, e.g. by Lexer::tokenize()
+class BufferTokenStream : public TokenStream {
+public:
+    BufferTokenStream(const TokenBuffer& tokens) : BufferTokenStream(tokens, 0, tokens.tokens.size() - 1) {}
+    // Replays the statement in tokens [first, last), then END where tokens[last] (the END or
+    // NEWLINE token after it) is
+    BufferTokenStream(const TokenBuffer& tokens, size_t first, size_t last)
+        : tokens(tokens), index(first), last(last) {}
+    Token next() override;
+    std::string_view text(const Token& token) const override { return tokens.text(token); }
+
+private:
+    const TokenBuffer& tokens;
+    size_t index;
+    size_t last;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "typeInference.h"
+#include <utility>
+#include <vector>
+
+static bool isArithmeticOperator(std::string_view op) {
+    return op == "+" || op == "-" || op == "*" || op == "/" || op == "%";
+}
+
+static bool isComparisonOperator(std::string_view op) {
+    return op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=";
+}
+
+// True when the annotated subtree contains a comparison or logical operator. An arithmetic
+// operation over such a result still prints as a boolean, as it always has.
+static bool hasBoolean(const ASTNode* node) {
+    while (node->kind == NodeKind::ASSIGNMENT) {
+        node = static_cast<const Assignment*>(node)->expression;
+    }
+    return node->kind == NodeKind::BINARY_OPERATION && node->type == ValueType::BOOLEAN;
+}
+
+// Sets the type of a node whose operands are already annotated
+static void annotate(ASTNode* node) {
+    switch (node->kind) {
+    case NodeKind::NUMBER:
+        node->type = ValueType::NUMBER;
+        return;
+    case NodeKind::BOOLEAN:
+        node->type = ValueType::BOOLEAN;
+        return;
+    case NodeKind::VARIABLE:
+    case NodeKind::ASSIGNMENT:
+        node->type = ValueType::DYNAMIC;
+        return;
+    case NodeKind::BINARY_OPERATION: {
+        BinaryOperation* binOp = static_cast<BinaryOperation*>(node);
+        // Only boolean literals are rejected statically; logical operators check their values at runtime
+        bool leftIsLiteral = binOp->left->kind == NodeKind::BOOLEAN;
+        bool rightIsLiteral = binOp->right->kind == NodeKind::BOOLEAN;
+        if (isArithmeticOperator(binOp->op)) {
+            binOp->invalidOperands = leftIsLiteral || rightIsLiteral;
+            binOp->type = (hasBoolean(binOp->left) || hasBoolean(binOp->right)) ? ValueType::BOOLEAN
+                                                                                : ValueType::NUMBER;
+            return;
+        }
+        if (isComparisonOperator(binOp->op)) {
+            binOp->invalidOperands = leftIsLiteral != rightIsLiteral;
+        }
+        binOp->type = ValueType::BOOLEAN;
+        return;
+    }
+    }
+}
+
+void inferTypes(ASTNode* root) {
+    if (!root) {
+        return;
+    }
+    // Post-order walk on an explicit stack; a subtree shared by NodeTable is annotated once
+    std::vector<std::pair<ASTNode*, bool>> pending;  // node, operands already annotated
+    std::vector<bool> sharedDone;
+    pending.push_back({root, false});
+    while (!pending.empty()) {
+        auto [node, operandsDone] = pending.back();
+        pending.pop_back();
+        size_t shared = static_cast<size_t>(node->sharedSlot);
+        if (node->sharedSlot >= 0 && shared < sharedDone.size() && sharedDone[shared]) {
+            continue;
+        }
+        if (!operandsDone && node->kind == NodeKind::ASSIGNMENT) {
+            pending.push_back({node, true});
+            pending.push_back({static_cast<Assignment*>(node)->expression, false});
+            continue;
+        }
+        if (!operandsDone && node->kind == NodeKind::BINARY_OPERATION) {
+            BinaryOperation* binOp = static_cast<BinaryOperation*>(node);
+            pending.push_back({node, true});
+            pending.push_back({binOp->right, false});
+            pending.push_back({binOp->left, false});
+            continue;
+        }
+        annotate(node);
+        if (node->sharedSlot >= 0) {
+            if (shared >= sharedDone.size()) {
+                sharedDone.resize(shared + 1, false);
+            }
+            sharedDone[shared] = true;
+        }
+    }
+}
@@ -0,0 +1,10 @@
+#ifndef TYPEINFERENCE_H
+#define TYPEINFERENCE_H
+
+#include "infixParser.h"
+
+// Annotate every node of a parsed tree with its static type and mark binary operations
+// whose operands the operator rejects. infixParser::infixparse() runs this on its result.
+void inferTypes(ASTNode* root);
+
+#endif
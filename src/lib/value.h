@@ -0,0 +1,39 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <iostream>
+
+// Static type of an expression, as inferred once after parsing
+enum class ValueType {
+    NUMBER,
+    BOOLEAN,
+    DYNAMIC   // decided by the runtime value: 0 and 1 are booleans, anything else is a number
+};
+
+// Result of evaluating a statement, tagged as either a number or a boolean
+struct Value {
+    ValueType type;   // NUMBER or BOOLEAN, never DYNAMIC
+    double number;
+
+    Value(ValueType type, double number) : type(type), number(number) {}
+
+    // Tag a raw evaluation result using the static type of the expression that produced it
+    static Value fromResult(ValueType staticType, double result) {
+        if (staticType == ValueType::DYNAMIC) {
+            staticType = (result == 1.0 || result == 0.0) ? ValueType::BOOLEAN : ValueType::NUMBER;
+        }
+        return Value(staticType, result);
+    }
+
+    bool isBoolean() const { return type == ValueType::BOOLEAN; }
+    bool asBoolean() const { return number == 1.0; }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Value& value) {
+    if (value.isBoolean()) {
+        return out << (value.asBoolean() ? "true" : "false");
+    }
+    return out << value.number;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#include "vm.h"
+#include <cmath>
+
+// Logical operators only accept the values a comparison or boolean can produce
+static bool isLogicalOperand(double value) {
+    return value == 1.0 || value == 0.0;
+}
+
+double VirtualMachine::run(const Program& program, SymbolTable& symbolTable) {
+    if (stack.size() < program.maxStackDepth + 1) {
+        stack.resize(program.maxStackDepth + 1);
+    }
+    double* sp = stack.data();  // points one past the top of the stack
+    const Instruction* ip = program.code.data();
+
+    while (true) {
+        const Instruction& instruction = *ip++;
+        switch (instruction.op) {
+        case OpCode::PUSH_CONST:
+            *sp++ = program.constants[instruction.operand];
+            break;
+        case OpCode::LOAD_VAR:
+            if (!symbolTable.isDefined(instruction.operand)) {
+                throw UnknownIdentifierException(symbolTable.name(instruction.operand));
+            }
+            *sp++ = symbolTable.get(instruction.operand);
+            break;
+        case OpCode::STORE_VAR:
+            symbolTable.set(instruction.operand, sp[-1]);
+            break;
+        case OpCode::ADD:
+            sp--;
+            sp[-1] = sp[-1] + sp[0];
+            break;
+        case OpCode::SUB:
+            sp--;
+            sp[-1] = sp[-1] - sp[0];
+            break;
+        case OpCode::MUL:
+            sp--;
+            sp[-1] = sp[-1] * sp[0];
+            break;
+        case OpCode::DIV:
+            sp--;
+            if (sp[0] == 0) {
+                throw DivisionByZeroException();
+            }
+            sp[-1] = sp[-1] / sp[0];
+            break;
+        case OpCode::MOD:
+            sp--;
+            sp[-1] = std::fmod(sp[-1], sp[0]);
+            break;
+        case OpCode::LESS:
+            sp--;
+            sp[-1] = sp[-1] < sp[0] ? 1 : 0;
+            break;
+        case OpCode::GREATER:
+            sp--;
+            sp[-1] = sp[-1] > sp[0] ? 1 : 0;
+            break;
+        case OpCode::LESS_EQUAL:
+            sp--;
+            sp[-1] = sp[-1] <= sp[0] ? 1 : 0;
+            break;
+        case OpCode::GREATER_EQUAL:
+            sp--;
+            sp[-1] = sp[-1] >= sp[0] ? 1 : 0;
+            break;
+        case OpCode::EQUAL:
+            sp--;
+            sp[-1] = sp[-1] == sp[0] ? 1 : 0;
+            break;
+        case OpCode::NOT_EQUAL:
+            sp--;
+            sp[-1] = sp[-1] != sp[0] ? 1 : 0;
+            break;
+        case OpCode::AND:
+            sp--;
+            if (!isLogicalOperand(sp[-1]) || !isLogicalOperand(sp[0])) {
+                throw InvalidOperandTypeException();
+            }
+            sp[-1] = static_cast<int>(sp[-1]) & static_cast<int>(sp[0]);
+            break;
+        case OpCode::XOR:
+            sp--;
+            if (!isLogicalOperand(sp[-1]) || !isLogicalOperand(sp[0])) {
+                throw InvalidOperandTypeException();
+            }
+            sp[-1] = static_cast<int>(sp[-1]) ^ static_cast<int>(sp[0]);
+            break;
+        case OpCode::OR:
+            sp--;
+            if (!isLogicalOperand(sp[-1]) || !isLogicalOperand(sp[0])) {
+                throw InvalidOperandTypeException();
+            }
+            sp[-1] = static_cast<int>(sp[-1]) | static_cast<int>(sp[0]);
+            break;
+        case OpCode::INVALID_OPERAND:
+            throw InvalidOperandTypeException();
+        case OpCode::HALT:
+            return sp[-1];
+        }
+    }
+}
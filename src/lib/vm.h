@@ -0,0 +1,18 @@
+#ifndef VM_H
+#define VM_H
+
+#include <vector>
+#include "bytecode.h"
+#include "symbolTable.h"
+
+// Stack machine that runs compiled statements against the symbol table
+class VirtualMachine {
+public:
+    double run(const Program& program, SymbolTable& symbolTable);
+
+private:
+    // Operand stack, kept between runs so it is only allocated once
+    std::vector<double> stack;
+};
+
+#endif